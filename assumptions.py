@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Incremental Assumption Manager
+
+Maintains the assumption vector handed to the SAT solver persistently instead
+of rebuilding it from scratch on every call. The vector consists of:
+- permanent assumptions (append-only, e.g. fixed rule conclusions)
+- named slots (e.g. the current fire/value variable of each existential's
+  decision list), overwritten in place when a rule or default changes
+
+The expansion-variable assignment, which forms the rest of the assumption
+vector, lives in the dense ExpansionModelStore (see expansion_store).
+"""
+
+from typing import Dict, Hashable, List
+
+
+class AssumptionManager:
+  """Persistently maintained assumption vector with delta updates."""
+
+  def __init__(self):
+    # Base region: permanent assumptions and named slots
+    self._base: List[int] = []
+
+    # Mapping from slot key to index into the base region
+    self._slot_index: Dict[Hashable, int] = {}
+
+  def add_permanent(self, lit: int) -> None:
+    """Append a permanent assumption literal (never changed later)."""
+    self._base.append(lit)
+
+  def set_slot(self, key: Hashable, lit: int) -> None:
+    """Create or overwrite a named assumption slot.
+
+    Args:
+      key: Hashable slot identifier (e.g. ('fire', existential_var_id))
+      lit: The literal the slot should now hold
+    """
+    index = self._slot_index.get(key)
+    if index is None:
+      self._slot_index[key] = len(self._base)
+      self._base.append(lit)
+    else:
+      self._base[index] = lit
+
+  def base_literals(self) -> List[int]:
+    """Return the base region (permanent assumptions and slots).
+
+    The returned list is the live buffer; callers must not mutate it.
+    """
+    return self._base
+
+  def __len__(self) -> int:
+    """Return the number of maintained assumption literals."""
+    return len(self._base)
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Batch and Server Mode with Preloaded Formula State
+
+Solving thousands of small DQCIR jobs one process at a time pays
+interpreter startup, PySAT import, parsing, and solver bootstrap per job —
+often more than the solve itself. This module keeps one warm process that
+accepts a stream of jobs (a file list in batch mode, filenames on stdin in
+server mode) and solves them with shared state.
+
+Jobs that share their circuit structure and differ only in the output(...)
+line additionally reuse the parsed circuit and its Tseitin clauses: the
+structure cache is keyed by a content hash that excludes output lines, and
+a hit just re-resolves the output gate. To keep a cached circuit valid for
+any future output choice, batch parsing skips the output-cone circuit
+reduction — the full-circuit CNF encodes every gate, and the solver only
+ever assumes the chosen output variable.
+"""
+
+import hashlib
+import logging
+import sys
+
+from counter import Counter
+from dqcir_parser import DQCIRParser
+from dqbf_solver import DQBFSolver
+from dependency_scheme import refine_dependencies
+
+
+def _structure_key(filename):
+  """Hash a DQCIR file's content with output lines excluded.
+
+  Args:
+    filename: Path to the DQCIR file
+
+  Returns:
+    (hex digest of the structure, output gate name or None)
+  """
+  digest = hashlib.sha256()
+  output_name = None
+  with open(filename, 'r') as f:
+    for line in f:
+      stripped = line.strip()
+      if stripped.startswith('output(') or stripped.startswith('output ('):
+        start = stripped.index('(') + 1
+        end = stripped.rindex(')')
+        output_name = stripped[start:end].strip()
+        continue
+      digest.update(line.encode())
+  return digest.hexdigest(), output_name
+
+
+class FormulaServer:
+  """Warm in-process job runner with a circuit-structure cache."""
+
+  def __init__(self, refine_deps=True):
+    """Initialize the server.
+
+    Args:
+      refine_deps: Refine dependency sets with the standard dependency
+                   scheme once per cached structure
+    """
+    self.refine_deps = refine_deps
+    # Structure hash -> dict with the parser, max variable ID, and the
+    # (refined) dependencies shared by all jobs over that circuit
+    self._structures = {}
+
+  def _load_structure(self, filename):
+    """Parse and transform a circuit, reusing the cache when possible."""
+    key, output_name = _structure_key(filename)
+    entry = self._structures.get(key)
+    if entry is not None:
+      logging.debug(f"Structure cache hit for {filename}")
+      return entry, output_name
+
+    parser = DQCIRParser(counter=Counter(0))
+    parser.parse_file(filename)
+    # No reduce_circuit: the cone of influence depends on the output gate,
+    # and the cached circuit must stay valid for other output choices
+    parser.tseitin_transform()
+
+    max_id = max(parser.name_to_id.values()) if parser.name_to_id else 0
+    for clause in parser.cnf:
+      for lit in clause:
+        max_id = max(max_id, abs(lit))
+
+    dependencies = parser.dependencies.copy()
+    if self.refine_deps:
+      universal_ids = [parser.name_to_id[v] for v in parser.forall_vars_ordered]
+      deps_by_id = {
+        parser.name_to_id[exist_var]: {parser.name_to_id[dep] for dep in deps}
+        for exist_var, deps in dependencies.items()
+      }
+      refined = refine_dependencies(parser.cnf, universal_ids, deps_by_id)
+      dependencies = {
+        exist_var: [dep for dep in deps
+                    if parser.name_to_id[dep] in refined[parser.name_to_id[exist_var]]]
+        for exist_var, deps in dependencies.items()
+      }
+
+    entry = {'parser': parser, 'max_id': max_id, 'dependencies': dependencies}
+    self._structures[key] = entry
+    return entry, output_name
+
+  def solve_file(self, filename):
+    """Solve one DQCIR file with the warm state.
+
+    Args:
+      filename: Path to the DQCIR file
+
+    Returns:
+      'SATISFIABLE' or 'UNSATISFIABLE'
+    """
+    entry, output_name = self._load_structure(filename)
+    parser = entry['parser']
+
+    if output_name is not None:
+      parser.output_gate = output_name
+    if not parser.output_gate:
+      raise ValueError("No output gate specified in the formula")
+    output_gate_id = parser.get_output_gate_id()
+
+    solver = DQBFSolver(
+      name_to_id=parser.name_to_id.copy(),
+      id_to_name=parser.id_to_name.copy(),
+      dependencies=entry['dependencies'],
+      matrix=parser.cnf.copy(),
+      universal_vars=parser.forall_vars_ordered.copy(),
+      output_gate_id=output_gate_id,
+      counter=Counter(entry['max_id'])
+    )
+    try:
+      result = solver.solve()
+    finally:
+      solver.close()
+    return 'SATISFIABLE' if result else 'UNSATISFIABLE'
+
+
+def run_batch(server, list_path):
+  """Solve every file named in a list file, one per line.
+
+  Args:
+    server: The FormulaServer jobs run on
+    list_path: Path to a text file listing DQCIR files (blank lines and
+               lines starting with # are skipped)
+
+  Returns:
+    Process exit code: 0 when every job solved, 1 when any job failed
+  """
+  with open(list_path) as f:
+    jobs = [line.strip() for line in f
+            if line.strip() and not line.strip().startswith('#')]
+
+  failures = 0
+  for index, filename in enumerate(jobs, 1):
+    try:
+      result = server.solve_file(filename)
+    except Exception as e:
+      logging.error(f"Error solving {filename}: {e}")
+      result = 'ERROR'
+      failures += 1
+    print(f"{filename}: {result}")
+    sys.stdout.flush()
+    logging.info(f"[{index}/{len(jobs)}] {filename}: {result}")
+
+  logging.info(f"Batch finished: {len(jobs) - failures}/{len(jobs)} jobs solved")
+  return 0 if failures == 0 else 1
+
+
+def serve(server, in_stream, out_stream):
+  """Answer a stream of jobs, one filename per line, until EOF or 'quit'.
+
+  Each answer is one line: "RESULT <filename> <SATISFIABLE|UNSATISFIABLE>"
+  or "RESULT <filename> ERROR <message>".
+
+  Args:
+    server: The FormulaServer jobs run on
+    in_stream: Input stream of job lines (e.g. sys.stdin)
+    out_stream: Output stream answers are written to (e.g. sys.stdout)
+  """
+  logging.info("Server ready; reading filenames from input (quit to stop)")
+  for line in in_stream:
+    filename = line.strip()
+    if not filename:
+      continue
+    if filename in ('quit', 'exit'):
+      break
+    try:
+      result = server.solve_file(filename)
+      out_stream.write(f"RESULT {filename} {result}\n")
+    except Exception as e:
+      out_stream.write(f"RESULT {filename} ERROR {e}\n")
+    out_stream.flush()
+  logging.info("Server stopped")
@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Benchmark Harness and Result Diffing
+
+Runs the solver over a directory of DQCIR instances with per-instance wall
+time and memory limits, collecting wall time, CEGAR iteration counts,
+SAT-call counts, rule counts, and peak RSS into a machine-readable JSON
+result set (optionally mirrored as CSV). Two result sets can then be
+diffed for speedup statistics and a scatter-plot-ready table, so a solver
+change can be judged against a baseline instead of eyeballed.
+
+Usage:
+  python benchmark.py run instances/ --output new.json --timeout 600
+  python benchmark.py run instances/ --output new.json --solver-args "--batch-size 4"
+  python benchmark.py diff baseline.json new.json --scatter scatter.dat
+"""
+
+import argparse
+import csv
+import json
+import logging
+import math
+import os
+import resource
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+# Exit codes of dqbf_solver.main for the two conclusive results
+EXIT_SAT = 10
+EXIT_UNSAT = 20
+
+# Statistics columns mirrored into the CSV output (the JSON keeps them all)
+CSV_STATISTICS = ['iterations', 'sat_calls', 'expansion_sat_calls', 'rules_added', 'clauses_added']
+
+
+def _limit_memory(limit_mb):
+  """Return a preexec function capping the child's address space, or None."""
+  if limit_mb is None:
+    return None
+  limit_bytes = limit_mb * 1024 * 1024
+  def apply_limit():
+    resource.setrlimit(resource.RLIMIT_AS, (limit_bytes, limit_bytes))
+  return apply_limit
+
+
+def run_instance(solver_script, instance, timeout, memory_mb, solver_args):
+  """Run the solver on one instance and collect its result record.
+
+  Args:
+    solver_script: Path to dqbf_solver.py
+    instance: Path to the DQCIR instance
+    timeout: Per-instance wall time limit in seconds (None for no limit)
+    memory_mb: Per-instance address-space limit in megabytes (None for no limit)
+    solver_args: Extra solver command-line arguments
+
+  Returns:
+    Result dictionary with instance name, result, exit code, wall time,
+    peak RSS, and the solver's statistics (empty for timeouts and errors)
+  """
+  record = {
+    'instance': os.path.basename(instance),
+    'result': 'error',
+    'exit_code': None,
+    'wall_seconds': None,
+    'peak_rss_kb': None,
+    'statistics': {},
+  }
+
+  with tempfile.NamedTemporaryFile(suffix='.json', delete=False) as stats_file:
+    stats_path = stats_file.name
+
+  command = [sys.executable, solver_script, instance, '--stats-json', stats_path] + solver_args
+  start = time.time()
+  try:
+    completed = subprocess.run(
+      command,
+      stdout=subprocess.DEVNULL,
+      stderr=subprocess.DEVNULL,
+      timeout=timeout,
+      preexec_fn=_limit_memory(memory_mb)
+    )
+    record['exit_code'] = completed.returncode
+    record['wall_seconds'] = time.time() - start
+
+    if completed.returncode in (EXIT_SAT, EXIT_UNSAT):
+      record['result'] = 'SATISFIABLE' if completed.returncode == EXIT_SAT else 'UNSATISFIABLE'
+      try:
+        with open(stats_path) as f:
+          stats_record = json.load(f)
+        record['peak_rss_kb'] = stats_record.get('peak_rss_kb')
+        record['statistics'] = stats_record.get('statistics', {})
+      except (OSError, json.JSONDecodeError):
+        logging.warning(f"  No statistics record for {instance}")
+  except subprocess.TimeoutExpired:
+    record['result'] = 'timeout'
+    record['wall_seconds'] = time.time() - start
+  finally:
+    try:
+      os.unlink(stats_path)
+    except OSError:
+      pass
+
+  return record
+
+
+def run_directory(args):
+  """Run the solver over every DQCIR instance in a directory."""
+  instances = sorted(
+    os.path.join(args.directory, name)
+    for name in os.listdir(args.directory)
+    if name.endswith('.dqcir')
+  )
+  if not instances:
+    logging.error(f"No .dqcir instances found in {args.directory}")
+    sys.exit(1)
+
+  solver_script = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'dqbf_solver.py')
+  solver_args = shlex.split(args.solver_args)
+
+  logging.info(f"Running {len(instances)} instances "
+               f"(timeout: {args.timeout or 'none'} s, memory: {args.memory or 'none'} MB)")
+
+  results = []
+  for index, instance in enumerate(instances, 1):
+    record = run_instance(solver_script, instance, args.timeout, args.memory, solver_args)
+    results.append(record)
+    wall = f"{record['wall_seconds']:.2f}s" if record['wall_seconds'] is not None else "-"
+    logging.info(f"  [{index}/{len(instances)}] {record['instance']}: {record['result']} ({wall})")
+
+  result_set = {
+    'directory': os.path.abspath(args.directory),
+    'timestamp': time.strftime('%Y-%m-%d %H:%M:%S'),
+    'timeout_seconds': args.timeout,
+    'memory_mb': args.memory,
+    'solver_args': solver_args,
+    'results': results,
+  }
+  with open(args.output, 'w') as f:
+    json.dump(result_set, f, indent=2)
+  logging.info(f"Wrote {len(results)} results to {args.output}")
+
+  if args.csv:
+    write_csv(results, args.csv)
+    logging.info(f"Wrote CSV mirror to {args.csv}")
+
+  solved = sum(1 for record in results if record['result'] in ('SATISFIABLE', 'UNSATISFIABLE'))
+  timeouts = sum(1 for record in results if record['result'] == 'timeout')
+  logging.info(f"Solved {solved}/{len(results)} ({timeouts} timeouts)")
+
+
+def write_csv(results, path):
+  """Mirror a result list as CSV with one row per instance."""
+  columns = ['instance', 'result', 'exit_code', 'wall_seconds', 'peak_rss_kb'] + CSV_STATISTICS
+  with open(path, 'w', newline='') as f:
+    writer = csv.writer(f)
+    writer.writerow(columns)
+    for record in results:
+      row = [record['instance'], record['result'], record['exit_code'],
+             record['wall_seconds'], record['peak_rss_kb']]
+      row.extend(record['statistics'].get(name) for name in CSV_STATISTICS)
+      writer.writerow(row)
+
+
+def diff_results(args):
+  """Compare two result sets and report speedup statistics."""
+  with open(args.baseline) as f:
+    baseline = {record['instance']: record for record in json.load(f)['results']}
+  with open(args.candidate) as f:
+    candidate = {record['instance']: record for record in json.load(f)['results']}
+
+  common = sorted(set(baseline) & set(candidate))
+  if not common:
+    logging.error("The result sets share no instances")
+    sys.exit(1)
+
+  conclusive = ('SATISFIABLE', 'UNSATISFIABLE')
+  speedups = []
+  faster = slower = 0
+  gained = []
+  lost = []
+  scatter_rows = []
+
+  for instance in common:
+    old, new = baseline[instance], candidate[instance]
+
+    # A result flip between two runs on the same instance is a correctness
+    # alarm, not a performance data point
+    if (old['result'] in conclusive and new['result'] in conclusive and
+        old['result'] != new['result']):
+      logging.error(f"  RESULT MISMATCH on {instance}: "
+                    f"{old['result']} vs {new['result']}")
+      continue
+
+    if old['result'] in conclusive and new['result'] not in conclusive:
+      lost.append(instance)
+      continue
+    if old['result'] not in conclusive and new['result'] in conclusive:
+      gained.append(instance)
+      continue
+    if old['result'] not in conclusive or new['result'] not in conclusive:
+      continue
+
+    old_time, new_time = old['wall_seconds'], new['wall_seconds']
+    scatter_rows.append((instance, old_time, new_time, new['result']))
+    if new_time > 0:
+      speedups.append(old_time / new_time)
+      if old_time > new_time:
+        faster += 1
+      elif old_time < new_time:
+        slower += 1
+
+  print(f"Instances compared: {len(common)}")
+  print(f"Solved by both: {len(scatter_rows)} ({faster} faster, {slower} slower)")
+  print(f"Newly solved: {len(gained)}" + (f" ({', '.join(gained)})" if gained else ""))
+  print(f"Newly unsolved: {len(lost)}" + (f" ({', '.join(lost)})" if lost else ""))
+  if speedups:
+    geomean = math.exp(sum(math.log(s) for s in speedups) / len(speedups))
+    total_old = sum(row[1] for row in scatter_rows)
+    total_new = sum(row[2] for row in scatter_rows)
+    print(f"Geometric mean speedup: {geomean:.3f}x")
+    print(f"Total wall time: {total_old:.2f}s -> {total_new:.2f}s")
+
+  if args.scatter:
+    with open(args.scatter, 'w') as f:
+      f.write("# instance baseline_seconds candidate_seconds result\n")
+      for instance, old_time, new_time, result in scatter_rows:
+        f.write(f"{instance} {old_time:.6f} {new_time:.6f} {result}\n")
+    logging.info(f"Wrote scatter data to {args.scatter}")
+
+
+def main():
+  parser = argparse.ArgumentParser(description='DQBF solver benchmark harness')
+  subparsers = parser.add_subparsers(dest='command', required=True)
+
+  run_parser = subparsers.add_parser('run', help='Run the solver over a directory of instances')
+  run_parser.add_argument('directory', type=str, help='Directory containing .dqcir instances')
+  run_parser.add_argument('--output', type=str, required=True, metavar='FILE',
+                          help='JSON result set to write')
+  run_parser.add_argument('--csv', type=str, default=None, metavar='FILE',
+                          help='Also mirror the results as CSV')
+  run_parser.add_argument('--timeout', type=float, default=None, metavar='S',
+                          help='Per-instance wall time limit in seconds (default: none)')
+  run_parser.add_argument('--memory', type=int, default=None, metavar='MB',
+                          help='Per-instance address-space limit in megabytes (default: none)')
+  run_parser.add_argument('--solver-args', type=str, default='', metavar='ARGS',
+                          help='Extra solver arguments, e.g. "--batch-size 4 --pipeline"')
+  run_parser.set_defaults(func=run_directory)
+
+  diff_parser = subparsers.add_parser('diff', help='Compare two result sets')
+  diff_parser.add_argument('baseline', type=str, help='Baseline JSON result set')
+  diff_parser.add_argument('candidate', type=str, help='Candidate JSON result set')
+  diff_parser.add_argument('--scatter', type=str, default=None, metavar='FILE',
+                           help='Write a scatter-plot-ready (instance, baseline, candidate) table')
+  diff_parser.set_defaults(func=diff_results)
+
+  args = parser.parse_args()
+  logging.basicConfig(level=logging.INFO, format='%(levelname)s: %(message)s')
+  args.func(args)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Skolem-Function Certificate Extraction
+
+Converts the final decision lists of a satisfiable run directly into
+Skolem-function circuits and writes them in ASCII AIGER (aag) format, with
+universal variables as inputs and one output per existential variable.
+
+The translation is purely syntactic: each existential's decision list
+becomes a chain of if-then-else nodes, one per rule in priority order, whose
+condition is the conjunction of the rule's premise literals and whose branch
+value is the rule's expansion-variable value from the final expansion model,
+falling back to the default value when no rule fires. No SAT call is made
+per universal assignment, so extraction is linear in the model size instead
+of exponential in the number of universals, and the resulting AIGER file can
+be checked by independent tools.
+"""
+
+import logging
+from typing import Dict, List, Tuple
+
+# AIGER constant literals
+AIG_FALSE = 0
+AIG_TRUE = 1
+
+
+class AigBuilder:
+  """Minimal AIG construction with structural hashing of AND nodes."""
+
+  def __init__(self, num_inputs: int):
+    # Variable indices 1..num_inputs are the inputs; ANDs follow
+    self.num_inputs = num_inputs
+    self.next_index = num_inputs + 1
+    self.and_gates: List[Tuple[int, int, int]] = []
+    self._hash: Dict[Tuple[int, int], int] = {}
+
+  def and_(self, a: int, b: int) -> int:
+    """Return the literal for a AND b, reusing constants and existing nodes."""
+    if a == AIG_FALSE or b == AIG_FALSE or a == (b ^ 1):
+      return AIG_FALSE
+    if a == AIG_TRUE:
+      return b
+    if b == AIG_TRUE or a == b:
+      return a
+
+    key = (min(a, b), max(a, b))
+    existing = self._hash.get(key)
+    if existing is not None:
+      return existing
+
+    lhs = 2 * self.next_index
+    self.next_index += 1
+    self.and_gates.append((lhs, key[1], key[0]))
+    self._hash[key] = lhs
+    return lhs
+
+  def or_(self, a: int, b: int) -> int:
+    """Return the literal for a OR b."""
+    return self.and_(a ^ 1, b ^ 1) ^ 1
+
+  def ite(self, condition: int, then_lit: int, else_lit: int) -> int:
+    """Return the literal for if condition then then_lit else else_lit."""
+    return self.or_(self.and_(condition, then_lit),
+                    self.and_(condition ^ 1, else_lit))
+
+
+def write_certificate(solver, path: str) -> None:
+  """Write the solver's decision lists as an AIGER (aag) Skolem certificate.
+
+  Args:
+    solver: A DQBFSolver whose solve() returned True (the decision lists and
+            expansion model together form the witnessing strategy)
+    path: Output file path for the aag certificate
+  """
+  universal_ids = solver.universal_var_ids
+  builder = AigBuilder(len(universal_ids))
+
+  # Universal variable ID -> AIGER input literal
+  input_literal = {var_id: 2 * (index + 1) for index, var_id in enumerate(universal_ids)}
+
+  outputs: List[Tuple[str, int]] = []
+  for exist_id in solver.existential_var_ids:
+    default_value = solver.value_vars[exist_id] > 0
+    function_lit = AIG_TRUE if default_value else AIG_FALSE
+
+    # Later rules only apply when earlier ones do not fire, so fold the
+    # priority order back to front into an if-then-else chain
+    for premise, expansion_var in reversed(solver.rule_premises.get(exist_id, [])):
+      condition = AIG_TRUE
+      for lit in sorted(premise, key=abs):
+        universal_lit = input_literal[abs(lit)]
+        condition = builder.and_(condition, universal_lit if lit > 0 else universal_lit ^ 1)
+
+      # Expansion variables the expansion solver never constrained are free;
+      # any value is part of a winning strategy, so default them to true
+      value = solver.expansion_store.value_of(expansion_var)
+      value_lit = AIG_FALSE if value is False else AIG_TRUE
+
+      function_lit = builder.ite(condition, value_lit, function_lit)
+
+    outputs.append((solver.names.name_of(exist_id), function_lit))
+
+  with open(path, 'w') as f:
+    max_index = builder.next_index - 1
+    f.write(f"aag {max_index} {len(universal_ids)} 0 {len(outputs)} {len(builder.and_gates)}\n")
+    for var_id in universal_ids:
+      f.write(f"{input_literal[var_id]}\n")
+    for _, function_lit in outputs:
+      f.write(f"{function_lit}\n")
+    for lhs, rhs0, rhs1 in builder.and_gates:
+      f.write(f"{lhs} {rhs0} {rhs1}\n")
+    for index, var_id in enumerate(universal_ids):
+      f.write(f"i{index} {solver.names.name_of(var_id)}\n")
+    for index, (name, _) in enumerate(outputs):
+      f.write(f"o{index} {name}\n")
+    f.write("c\nSkolem-function certificate extracted from decision lists\n")
+
+  logging.info(f"Wrote Skolem certificate to {path} "
+               f"({len(universal_ids)} inputs, {len(outputs)} outputs, {len(builder.and_gates)} AND gates)")
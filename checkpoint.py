@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Checkpoint / Resume of Refinement State
+
+Hard instances run for days, and a crash loses every learned rule because
+DQBFSolver state lives only in process memory. A checkpoint serializes
+the refinement state that cannot be recomputed cheaply — the decision
+lists (rule premises with their expansion variables, in priority order),
+the current default values, the accumulated expansion blocking clauses,
+the counter value, and the iteration number — to an atomically replaced
+pickle. Restoring works like decision-list compaction: a freshly
+constructed solver replays the rules into its counterexample solver and
+the blocking clauses into its expansion solver, then solve() continues
+from the saved iteration. Everything else (the matrix, both SAT solvers'
+internal state, the expansion assignment) is rebuilt or recomputed, so
+the checkpoint stays proportional to the number of learned rules.
+"""
+
+import logging
+import os
+import pickle
+
+from var_index import KIND_EXPANSION
+
+# Bump whenever the snapshot layout changes
+CHECKPOINT_FORMAT_VERSION = 1
+
+
+def save_checkpoint(solver, path, iteration):
+  """Write the solver's refinement state to an atomically replaced snapshot.
+
+  Args:
+    solver: The DQBFSolver to snapshot
+    path: Checkpoint file path
+    iteration: The CEGAR iteration the snapshot represents
+  """
+  snapshot = {
+    'version': CHECKPOINT_FORMAT_VERSION,
+    'iteration': iteration,
+    'counter': solver.counter.n,
+    'matrix_clauses': len(solver.matrix),
+    'rules': {exist_id: list(solver.rule_premises.get(exist_id, []))
+              for exist_id in solver.existential_var_ids},
+    'defaults': {exist_id: solver.value_vars[exist_id] > 0
+                 for exist_id in solver.existential_var_ids},
+    'expansion_clauses': list(solver.expansion_clauses),
+  }
+
+  temp_path = path + '.tmp'
+  with open(temp_path, 'wb') as f:
+    pickle.dump(snapshot, f, protocol=pickle.HIGHEST_PROTOCOL)
+  # Atomic replace so a crash never leaves a truncated checkpoint behind
+  os.replace(temp_path, path)
+  logging.debug(f"Wrote checkpoint to {path} (iteration {iteration}, "
+                f"{sum(len(rules) for rules in snapshot['rules'].values())} rules)")
+
+
+def restore_checkpoint(solver, path):
+  """Rebuild a freshly constructed solver's state from a checkpoint.
+
+  The solver must have been constructed from the same formula the
+  checkpoint was taken on; the rules are replayed into its counterexample
+  solver and the blocking clauses into its expansion solver.
+
+  Args:
+    solver: A freshly constructed DQBFSolver for the same formula
+    path: Checkpoint file path
+
+  Returns:
+    The saved iteration number, for solve() to continue from
+
+  Raises:
+    ValueError: If the checkpoint has a different format version or was
+                taken on a different formula
+  """
+  with open(path, 'rb') as f:
+    snapshot = pickle.load(f)
+
+  if snapshot.get('version') != CHECKPOINT_FORMAT_VERSION:
+    raise ValueError(f"Checkpoint {path} has a stale format version")
+  if snapshot.get('matrix_clauses') != len(solver.matrix):
+    raise ValueError(f"Checkpoint {path} was taken on a different formula "
+                     f"({snapshot.get('matrix_clauses')} vs {len(solver.matrix)} clauses)")
+
+  # Replayed rules must not collide with the saved expansion variable IDs
+  solver.counter.n = snapshot['counter']
+
+  # Re-register the expansion variables under their saved identities
+  for exist_id, rules in snapshot['rules'].items():
+    trie = solver.expansion_tries[exist_id]
+    for premise, expansion_var in rules:
+      assignment_tuple = tuple(sorted(premise, key=abs))
+      solver.names.register_expansion(expansion_var, exist_id, assignment_tuple)
+      trie.store(premise, expansion_var)
+      solver.expansion_vars_set.add(expansion_var)
+      solver.kind_index.mark(expansion_var, KIND_EXPANSION)
+
+  # Rebuild the decision lists exactly as compaction does, then replay the
+  # expansion blocking clauses (the expansion solver holds no other state)
+  solver._reset_decision_lists()
+  solver._replay_rules(snapshot['rules'], snapshot['defaults'])
+  solver.clauses_since_compaction = 0
+  for clause in snapshot['expansion_clauses']:
+    solver._add_expansion_clause(clause)
+
+  rule_count = sum(len(rules) for rules in snapshot['rules'].values())
+  logging.info(f"Resumed from checkpoint {path}: iteration {snapshot['iteration']}, "
+               f"{rule_count} rules, {len(snapshot['expansion_clauses'])} expansion clauses")
+  return snapshot['iteration']
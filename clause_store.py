@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Flat Clause Storage for the CNF Matrix
+
+A CNF matrix stored as a list of per-clause lists pays one Python list
+object, plus one boxed integer per literal, for every clause; on large
+formulas the matrix alone can dominate resident memory and clause iteration
+chases a pointer per literal. This store keeps all literals of all clauses
+in one contiguous signed 32-bit buffer with a second buffer of clause end
+offsets, so the matrix costs four bytes per literal regardless of clause
+count and copies or pickles as two flat arrays.
+
+The store exposes the small list-like surface the rest of the code uses
+(append, len, truthiness, indexing including slices, and iteration yielding
+per-clause literal lists), so it can replace the clause list produced by
+tseitin_transform without changing any consumer.
+"""
+
+from array import array
+from typing import Iterable, Iterator, List
+
+
+class ClauseStore:
+  """CNF clauses in one contiguous int32 literal buffer."""
+
+  def __init__(self, clauses: Iterable[List[int]] = ()):
+    """Initialize the store, optionally from an iterable of clauses.
+
+    Args:
+      clauses: Initial clauses to append, each a list of non-zero literals
+    """
+    # All literals back to back; clause i occupies
+    # _literals[_ends[i - 1]:_ends[i]] with an implicit _ends[-1] of 0
+    self._literals = array('i')
+    self._ends = array('l')
+    for clause in clauses:
+      self.append(clause)
+
+  def append(self, clause: List[int]) -> None:
+    """Append one clause (a list of non-zero literals)."""
+    self._literals.extend(clause)
+    self._ends.append(len(self._literals))
+
+  def __len__(self) -> int:
+    return len(self._ends)
+
+  def __getitem__(self, index):
+    """Return the clause at an index as a list, or a list of clauses for a slice."""
+    if isinstance(index, slice):
+      return [self[i] for i in range(*index.indices(len(self._ends)))]
+    if index < 0:
+      index += len(self._ends)
+    if index < 0 or index >= len(self._ends):
+      raise IndexError("clause index out of range")
+    start = self._ends[index - 1] if index > 0 else 0
+    return self._literals[start:self._ends[index]].tolist()
+
+  def __iter__(self) -> Iterator[List[int]]:
+    """Yield each clause as a list of literals."""
+    start = 0
+    for end in self._ends:
+      yield self._literals[start:end].tolist()
+      start = end
+
+  def copy(self) -> 'ClauseStore':
+    """Return an independent copy sharing no buffers with this store."""
+    copied = ClauseStore()
+    copied._literals = array('i', self._literals)
+    copied._ends = array('l', self._ends)
+    return copied
+
+  def literal_count(self) -> int:
+    """Return the total number of literals across all clauses."""
+    return len(self._literals)
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Definability-Based Existential Elimination
+
+Many existential variables are functionally defined by their dependencies:
+whenever the output holds, the matrix forces their value as a function of
+the dependency assignment. Running CEGAR refinement on such variables is
+wasted work, since any winning strategy must compute exactly that function.
+
+Detection uses Padoa's method: two copies of the matrix (plus the output
+constraint) share only the variable's dependencies; if assuming the variable
+true in one copy and false in the other is UNSAT, the variable is defined.
+Extraction then searches the circuit for a witness of the definition among
+constants, dependency literals, and gates whose input cone lies inside the
+dependency set, verifying each candidate with two SAT calls. A verified
+definition is substituted into the circuit (the variable becomes a gate) and
+the variable is dropped from the prefix, which preserves the truth value of
+the formula: in every satisfying total assignment the variable already
+equals its definition. Defined variables without a witness among the
+candidates are reported but kept.
+"""
+
+import logging
+from typing import Dict, List, Optional, Set, Tuple
+
+from pysat.solvers import Cadical195 as SAT
+from counter import Counter
+
+
+def _copy_matrix(matrix: List[List[int]], shared: Set[int], counter: Counter) -> Tuple[List[List[int]], Dict[int, int]]:
+  """Copy a CNF matrix, renaming all variables outside a shared set.
+
+  Args:
+    matrix: The clauses to copy
+    shared: Variable IDs kept identical in both copies
+    counter: Counter handing out fresh IDs for the renamed variables
+
+  Returns:
+    (copied clauses, mapping from original to renamed variable IDs)
+  """
+  renaming: Dict[int, int] = {}
+  copied = []
+  for clause in matrix:
+    new_clause = []
+    for lit in clause:
+      var = abs(lit)
+      if var in shared:
+        new_clause.append(lit)
+        continue
+      renamed = renaming.get(var)
+      if renamed is None:
+        renamed = counter.increase()
+        renaming[var] = renamed
+      new_clause.append(renamed if lit > 0 else -renamed)
+    copied.append(new_clause)
+  return copied, renaming
+
+
+def find_defined_existentials(
+  matrix: List[List[int]],
+  output_gate_id: int,
+  dependencies_by_id: Dict[int, Set[int]],
+  counter: Counter
+) -> List[int]:
+  """Find existentials defined by their dependencies, via Padoa's method.
+
+  Args:
+    matrix: CNF matrix of the circuit
+    output_gate_id: Output gate variable (assumed true in both copies)
+    dependencies_by_id: Existential ID -> set of universal dependency IDs
+    counter: Counter for the fresh variables of the renamed copies
+
+  Returns:
+    List of defined existential variable IDs
+  """
+  defined = []
+  for exist_id, deps in dependencies_by_id.items():
+    shared = set(deps)
+    copied, renaming = _copy_matrix(matrix, shared, counter)
+
+    # The renaming only covers variables occurring in matrix clauses; a
+    # variable in no clause (e.g. pruned from the output cone) is
+    # unconstrained and cannot be defined
+    renamed_exist = renaming.get(exist_id)
+    if renamed_exist is None:
+      continue
+
+    solver = SAT(bootstrap_with=matrix)
+    solver.append_formula(copied)
+
+    # Both copies must satisfy the output; the variable differs between them
+    assumptions = [output_gate_id, exist_id, -renamed_exist]
+    renamed_output = renaming.get(output_gate_id)
+    if renamed_output is not None:
+      assumptions.append(renamed_output)
+    if not solver.solve(assumptions=assumptions):
+      defined.append(exist_id)
+  return defined
+
+
+def _gate_input_cone(gates: Dict[int, dict], gate_id: int) -> Set[int]:
+  """Collect the input variables (non-gates) feeding a gate, iteratively."""
+  inputs: Set[int] = set()
+  seen: Set[int] = set()
+  stack = [gate_id]
+  while stack:
+    current = stack.pop()
+    if current in seen:
+      continue
+    seen.add(current)
+    gate_info = gates.get(current)
+    if gate_info is None:
+      inputs.add(current)
+      continue
+    stack.extend(inp_id for inp_id, _ in gate_info['inputs'])
+  return inputs
+
+
+def _find_witness(
+  solver,
+  output_gate_id: int,
+  exist_id: int,
+  deps: Set[int],
+  gates: Dict[int, dict]
+) -> Optional[Tuple[str, int]]:
+  """Search for a witness of a defined variable's definition.
+
+  Candidates are the constants, the dependency literals, and circuit gates
+  whose input cone lies inside the dependency set. A candidate c witnesses
+  the definition when matrix + output + (exist != c) is unsatisfiable,
+  checked with one SAT call per value of exist.
+
+  Args:
+    solver: SAT solver bootstrapped with the matrix
+    output_gate_id: Output gate variable (assumed true)
+    exist_id: The defined existential variable
+    deps: Its dependency set
+    gates: The circuit's gate table
+
+  Returns:
+    ('const', 1) / ('const', 0) for a constant definition, ('lit', lit) for
+    a literal or gate definition, or None if no candidate is a witness
+  """
+  # Constants first: exist is forced one way under the output
+  if not solver.solve(assumptions=[output_gate_id, -exist_id]):
+    return ('const', 1)
+  if not solver.solve(assumptions=[output_gate_id, exist_id]):
+    return ('const', 0)
+
+  candidate_vars = sorted(deps)
+  candidate_vars.extend(
+    gate_id for gate_id in sorted(gates)
+    if gate_id != exist_id and _gate_input_cone(gates, gate_id) <= deps
+  )
+
+  for var in candidate_vars:
+    for candidate in (var, -var):
+      if (not solver.solve(assumptions=[output_gate_id, exist_id, -candidate]) and
+          not solver.solve(assumptions=[output_gate_id, -exist_id, candidate])):
+        return ('lit', candidate)
+  return None
+
+
+def eliminate_defined_existentials(parser, output_gate_id: int) -> int:
+  """Substitute defined existentials into the circuit and drop them.
+
+  Args:
+    parser: A DQCIRParser whose circuit has been parsed and transformed
+            (parser.cnf must be the current CNF of the circuit)
+    output_gate_id: The resolved output gate ID
+
+  Returns:
+    Number of existential variables eliminated; if positive, the caller
+    must re-run the CNF transformation on the modified circuit
+  """
+  dependencies_by_id = {
+    parser.name_to_id[exist_var]: {parser.name_to_id[dep] for dep in deps}
+    for exist_var, deps in parser.dependencies.items()
+  }
+
+  max_id = max(parser.name_to_id.values()) if parser.name_to_id else 0
+  for clause in parser.cnf:
+    for lit in clause:
+      max_id = max(max_id, abs(lit))
+  scratch_counter = Counter(max_id)
+
+  defined = find_defined_existentials(parser.cnf, output_gate_id, dependencies_by_id, scratch_counter)
+  logging.info(f"Definability: {len(defined)} of {len(dependencies_by_id)} existentials are defined")
+  if not defined:
+    return 0
+
+  witness_solver = SAT(bootstrap_with=parser.cnf)
+  id_to_exist_name = {parser.name_to_id[exist_var]: exist_var for exist_var in parser.dependencies}
+
+  eliminated = 0
+  for exist_id in defined:
+    exist_name = id_to_exist_name[exist_id]
+    witness = _find_witness(witness_solver, output_gate_id, exist_id,
+                            dependencies_by_id[exist_id], parser.gates)
+    if witness is None:
+      logging.debug(f"  {exist_name} is defined but no witness was found; keeping it")
+      continue
+
+    kind, value = witness
+    if kind == 'const':
+      # Empty and() is constant true, empty or() constant false
+      parser.gates[exist_id] = {'type': 'and' if value else 'or', 'inputs': []}
+      logging.debug(f"  Substituting {exist_name} := {bool(value)}")
+    else:
+      parser.gates[exist_id] = {'type': 'and', 'inputs': [(abs(value), value < 0)]}
+      witness_name = parser.id_to_name.get(abs(value), f"id{abs(value)}")
+      logging.debug(f"  Substituting {exist_name} := {'~' if value < 0 else ''}{witness_name}")
+
+    del parser.dependencies[exist_name]
+    parser.exists_vars.discard(exist_name)
+    eliminated += 1
+
+  logging.info(f"Definability: eliminated {eliminated} existential variables")
+  return eliminated
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Dependency-Set Refinement
+
+Front-end dependency sets are grossly over-approximated: an exists(...)
+block without a depend(...) override receives every universal seen so far.
+Every spurious dependency doubles the potential expansion space, so this
+pass shrinks dependency sets with the standard dependency scheme computed
+over the CNF matrix before the solver is constructed.
+
+An existential e genuinely depends on a universal u only if some resolution
+path connects a clause containing u to a clause containing e, where
+consecutive clauses share a complementary literal on a variable that may
+itself depend on u (a declared existential with u in its dependency set, or
+a Tseitin auxiliary variable, which depends on everything). If no such path
+exists, u can be dropped from e's dependency set without changing the truth
+value of the formula.
+"""
+
+import logging
+from typing import Dict, List, Set
+
+
+def refine_dependencies(
+  matrix: List[List[int]],
+  universal_var_ids: List[int],
+  dependencies_by_id: Dict[int, Set[int]]
+) -> Dict[int, Set[int]]:
+  """Shrink dependency sets with the standard dependency scheme.
+
+  Args:
+    matrix: CNF matrix (clauses over universal, existential, and auxiliary
+            variables)
+    universal_var_ids: IDs of all universal variables
+    dependencies_by_id: Current dependency sets, existential ID -> set of
+            universal IDs
+
+  Returns:
+    Refined dependency sets (a new dictionary; the input is not modified)
+  """
+  universal_set = set(universal_var_ids)
+
+  # Occurrence index: literal -> clause indices containing it
+  occurrences: Dict[int, List[int]] = {}
+  for index, clause in enumerate(matrix):
+    for lit in clause:
+      occurrences.setdefault(lit, []).append(index)
+
+  refined = {exist_id: set(deps) for exist_id, deps in dependencies_by_id.items()}
+  removed = 0
+
+  for u in universal_var_ids:
+    # Variables resolution paths may connect through: anything that is not
+    # universal and not a declared existential independent of u (Tseitin
+    # auxiliaries depend on every universal and always connect)
+    def connects(var: int) -> bool:
+      if var in universal_set:
+        return False
+      declared_deps = dependencies_by_id.get(var)
+      return declared_deps is None or u in declared_deps
+
+    # BFS over clauses, starting from the occurrences of u and expanding
+    # through complementary literals on connecting variables
+    frontier = list(occurrences.get(u, ())) + list(occurrences.get(-u, ()))
+    visited_clauses = set(frontier)
+    expanded_literals: Set[int] = set()
+    reached_vars: Set[int] = set()
+
+    while frontier:
+      clause_index = frontier.pop()
+      for lit in matrix[clause_index]:
+        var = abs(lit)
+        if not connects(var):
+          continue
+        reached_vars.add(var)
+        if lit in expanded_literals:
+          continue
+        expanded_literals.add(lit)
+        for next_index in occurrences.get(-lit, ()):
+          if next_index not in visited_clauses:
+            visited_clauses.add(next_index)
+            frontier.append(next_index)
+
+    # Existentials with no resolution path from u do not depend on it
+    for exist_id, deps in refined.items():
+      if u in deps and exist_id not in reached_vars:
+        deps.discard(u)
+        removed += 1
+
+  total = sum(len(deps) for deps in dependencies_by_id.values())
+  logging.info(f"Dependency refinement removed {removed} of {total} dependencies")
+  return refined
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Interned Dependency Sets
+
+Instances routinely declare thousands of existential variables with
+identical dependency sets, yet the solver used to build a separate set and
+list per existential. This table stores each distinct dependency set once —
+as a canonical sorted ID tuple, a frozenset for membership tests, and a
+shared variable-to-trie-level map — and hands out a small integer handle
+that existentials reference instead. Besides the memory win, grouping
+existentials by handle lets per-counterexample work that only depends on
+the dependency set run once per distinct set instead of once per variable.
+"""
+
+from typing import Dict, FrozenSet, Iterable, List, Tuple
+
+
+class DependencyTable:
+  """Canonical table of distinct dependency sets, referenced by handle."""
+
+  def __init__(self):
+    # Handle lookup by frozenset, plus one canonical representation per
+    # handle: sorted ID tuple, frozenset, and trie level map
+    self._handles: Dict[FrozenSet[int], int] = {}
+    self._lists: List[Tuple[int, ...]] = []
+    self._sets: List[FrozenSet[int]] = []
+    self._level_maps: List[Dict[int, int]] = []
+
+  def intern(self, dep_ids: Iterable[int]) -> int:
+    """Return the handle for a dependency set, creating it on first use.
+
+    Args:
+      dep_ids: The dependency variable IDs (any order, duplicates ignored)
+
+    Returns:
+      The handle shared by every existential with this dependency set
+    """
+    dep_set = frozenset(dep_ids)
+    handle = self._handles.get(dep_set)
+    if handle is not None:
+      return handle
+
+    handle = len(self._lists)
+    self._handles[dep_set] = handle
+    dep_list = tuple(sorted(dep_set))
+    self._lists.append(dep_list)
+    self._sets.append(dep_set)
+    self._level_maps.append({var: level for level, var in enumerate(dep_list)})
+    return handle
+
+  def list_of(self, handle: int) -> Tuple[int, ...]:
+    """Return the canonical sorted ID tuple of a handle's dependency set."""
+    return self._lists[handle]
+
+  def set_of(self, handle: int) -> FrozenSet[int]:
+    """Return the frozenset of a handle's dependency set."""
+    return self._sets[handle]
+
+  def level_map(self, handle: int) -> Dict[int, int]:
+    """Return the shared variable-to-position map over the canonical order."""
+    return self._level_maps[handle]
+
+  def __len__(self) -> int:
+    return len(self._lists)
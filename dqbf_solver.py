@@ -11,7 +11,41 @@ from typing import Dict, List, Set, Tuple, Optional
 from pysat.solvers import Cadical195 as SAT
 from dqcir_parser import DQCIRParser
 from counter import Counter
+from var_index import VariableKindIndex, KIND_UNIVERSAL, KIND_EXISTENTIAL, KIND_EXPANSION
+from assumptions import AssumptionManager
+from instrumentation import Instrumentation
+from profiling import PhaseProfiler
+from name_table import NameTable
+from dependency_table import DependencyTable
+from expansion_trie import ExpansionTrie
+from expansion_store import ExpansionModelStore
+from polarity import PolarityTracker
+from portfolio import PortfolioSolver
+from equiv_parallel import ParallelPairChecker
+from dependency_scheme import refine_dependencies
+from concurrent.futures import ThreadPoolExecutor
+import checkpoint
 import logging
+import random
+
+
+class RuleRecord:
+  """Per-rule bookkeeping for one entry of a decision list.
+
+  Records are stored per existential variable in creation (priority) order,
+  so the rule number is simply the record's position in that list. The last
+  record is always the open "default" rule whose premise has not been fixed
+  yet; premise stays None until add_rule turns the default into a real rule.
+  """
+
+  __slots__ = ('fire_var', 'no_rule_fired_var', 'value_var', 'premise')
+
+  def __init__(self, fire_var: int, no_rule_fired_var: int, value_var: int):
+    self.fire_var = fire_var
+    # The "no rule before this one fired" variable gating this rule
+    self.no_rule_fired_var = no_rule_fired_var
+    self.value_var = value_var
+    self.premise: Optional[Tuple[int, ...]] = None
 
 
 class DQBFSolver:
@@ -25,25 +59,76 @@ class DQBFSolver:
     matrix: List[List[int]],
     universal_vars: List[str],
     output_gate_id: int,
-    counter: Optional[Counter] = None
+    counter: Optional[Counter] = None,
+    batch_size: int = 1,
+    portfolio_size: int = 0,
+    pipeline: bool = False,
+    compact_interval: int = 0,
+    profiler: Optional[PhaseProfiler] = None,
+    checkpoint_path: Optional[str] = None,
+    checkpoint_interval: int = 0,
+    polarity_window: int = 0,
+    polarity_hysteresis: int = 4
   ):
     """Initialize the DQBF solver.
-    
+
     Args:
       name_to_id: Dictionary mapping variable/gate names to integer IDs
       id_to_name: Dictionary mapping integer IDs to variable/gate names
       dependencies: Dictionary mapping existential variables to their dependencies
              Key: existential variable name
              Value: list of universal variable names it depends on
-      matrix: CNF matrix as list of clauses (each clause is a list of integers)
-          Positive integers are positive literals, negative are negated
+      matrix: CNF matrix, either a flat ClauseStore or a list of clauses;
+          iterating it yields clauses as lists of integers, where positive
+          integers are positive literals and negative are negated
       universal_vars: List of universal variable names in order of introduction
       output_gate_id: Integer ID of the output gate that must be satisfied
       counter: Optional Counter object. If None, creates a new Counter starting from
               the maximum variable ID seen in existential vars, universal vars, and matrix.
+      batch_size: Maximum number of counterexamples to extract and analyze per
+              CEGAR iteration (see get_counterexamples)
+      portfolio_size: Number of SAT worker processes racing each step-1
+              counterexample query (0 disables the portfolio)
+      pipeline: Overlap expansion solving with a speculative counterexample
+              search under the previous expansion assignment (see
+              _solve_pipelined)
+      compact_interval: Rebuild the decision lists and counterexample solver
+              after this many added clauses (0 disables compaction)
+      profiler: Optional PhaseProfiler collecting per-phase wall time and
+              SAT-call duration histograms; a disabled no-op profiler is
+              used when omitted
+      checkpoint_path: File the refinement state is periodically saved to
+              during solve (None disables checkpointing)
+      checkpoint_interval: Save a checkpoint every this many CEGAR
+              iterations (0 disables checkpointing)
+      polarity_window: Choose default values by the majority of the last
+              this many counterexamples per existential, with hysteresis,
+              instead of flipping on every counterexample (0 disables)
+      polarity_hysteresis: Majority margin required before a default flip
+              when polarity_window is enabled
     """
     self.name_to_id = name_to_id
+    self.batch_size = max(1, batch_size)
+    self.pipeline = pipeline
+    self.compact_interval = compact_interval
+    self.clauses_since_compaction = 0
+    self.checkpoint_path = checkpoint_path
+    self.checkpoint_interval = checkpoint_interval
+
+    # Optional sliding-window polarity statistics steering default values
+    self.polarity: Optional[PolarityTracker] = None
+    if polarity_window > 0:
+      self.polarity = PolarityTracker(polarity_window, polarity_hysteresis)
+
+    # Instrumentation: guarded tracing and performance counters
+    self.instr = Instrumentation()
+
+    # Per-phase wall-time accumulators (no-op unless --profile is given)
+    self.profiler = profiler if profiler is not None else PhaseProfiler(enabled=False)
     self.id_to_name = id_to_name
+
+    # Lazy display names for solver-created auxiliary variables
+    self.names = NameTable(id_to_name)
     self.dependencies = dependencies
     self.matrix = matrix
     self.universal_vars = universal_vars
@@ -72,15 +157,29 @@ class DQBFSolver:
     self.existential_vars = set(dependencies.keys())
     self.universal_var_ids = [name_to_id[v] for v in universal_vars]
     self.existential_var_ids = [name_to_id[v] for v in self.existential_vars]
-    
-    # Convert dependencies to ID-based mapping
-    self.dependencies_by_id: Dict[int, Set[int]] = {}
-    self.dependencies_by_id_list: Dict[int, List[int]] = {}
+
+    # Variable-kind index for O(1) literal classification
+    # IDs handed out by the counter later on default to auxiliary;
+    # expansion variables are marked in get_expansion_variable
+    self.kind_index = VariableKindIndex(self.counter.n)
+    self.kind_index.mark_all(self.universal_var_ids, KIND_UNIVERSAL)
+    self.kind_index.mark_all(self.existential_var_ids, KIND_EXISTENTIAL)
+    
+    # Interned dependency sets: each distinct set is stored once (canonical
+    # sorted tuple, frozenset, trie level map) and existentials reference it
+    # by handle, so per-set work and memory are paid per distinct set
+    self.dep_table = DependencyTable()
+    self.dep_handles: Dict[int, int] = {}
     for exist_var, deps in dependencies.items():
       exist_id = name_to_id[exist_var]
-      dep_ids = [name_to_id[dep] for dep in deps]
-      self.dependencies_by_id[exist_id] = set(dep_ids)
-      self.dependencies_by_id_list[exist_id] = dep_ids
+      self.dep_handles[exist_id] = self.dep_table.intern(name_to_id[dep] for dep in deps)
+
+    # Existentials grouped by shared dependency handle
+    self.exist_ids_by_handle: Dict[int, List[int]] = {}
+    for exist_id, handle in self.dep_handles.items():
+      if handle not in self.exist_ids_by_handle:
+        self.exist_ids_by_handle[handle] = []
+      self.exist_ids_by_handle[handle].append(exist_id)
 
     # Ordered decision list structures for existential variables
     # Each existential variable has a decision list of rules
@@ -97,35 +196,68 @@ class DQBFSolver:
     # Dictionary storing all rule fire variables for each existential variable
     # Key: existential variable ID, Value: current "rule fires" variable ID
     self.rule_fire_vars: Dict[int, int] = {}
+
+    # Premise rules per existential variable, in priority order (earliest first)
+    # Key: existential variable ID
+    # Value: list of (premise literal frozenset, expansion variable ID) tuples
+    self.rule_premises: Dict[int, List[Tuple[frozenset, int]]] = {}
     
-    # List of all rule fire variables with their premises for debugging/logging
-    # Each element is a tuple: (existential_var_id, fire_var_id, premise_name)
-    self.all_rule_fire_vars: List[Tuple[int, int, str]] = []
-    
-    # List of all no_rule_fired variables with their indices for debugging/logging
-    # Each element is a tuple: (existential_var_id, no_rule_fired_var_id, rule_index)
-    self.all_no_rule_fired_vars: List[Tuple[int, int, int]] = []
-    
-    # List of all value variables with their indices for debugging/logging
-    # Each element is a tuple: (existential_var_id, value_var_id, rule_index)
-    self.all_value_vars: List[Tuple[int, int, int]] = []
+    # Rule registry: one RuleRecord per rule, per existential variable, in
+    # creation (priority) order. Append and lookup are O(1); the rule number
+    # of a record is its 1-based position in the list
+    self.rules: Dict[int, List[RuleRecord]] = {}
     
     # Permanent assumptions (for fixed rule conclusions)
     self.permanent_assumptions: List[int] = []
-    
-    # Expansion variables: maps (existential_var_id, assignment_tuple) to expansion variable ID
-    # The assignment_tuple is a tuple of literals sorted by abs(lit)
-    # Key: (existential_var_id, tuple of sorted literals)
-    # Value: expansion variable ID
-    self.expansion_vars: Dict[Tuple[int, Tuple[int, ...]], int] = {}
-    
+
+    # Incrementally maintained assumption vector (permanent assumptions,
+    # per-existential fire/value slots, and the expansion-variable assignment)
+    self.assumption_manager = AssumptionManager()
+    
+    # Expansion variables: one trie per existential variable, indexed by
+    # (partial) assignments to its dependencies in a fixed order. Lookup and
+    # creation walk the dependency order once (O(d)) from unsorted literals;
+    # the dependency order and level map are shared via the interned table
+    self.expansion_tries: Dict[int, ExpansionTrie] = {
+      exist_id: ExpansionTrie(self.dep_table.list_of(handle), self.dep_table.level_map(handle))
+      for exist_id, handle in self.dep_handles.items()
+    }
+
     # Set of expansion variable IDs for quick lookup
     self.expansion_vars_set: Set[int] = set()
 
-    self.expansion_variable_assignment: List[int] = []
-    
+    # Current expansion-solver model: dense O(1) value lookup per expansion
+    # variable plus the flat literal list used as assumptions
+    self.expansion_store = ExpansionModelStore(self.counter.n)
+
     self.expansion_solver = SAT()
     self.counterexample_solver = SAT(bootstrap_with=matrix)
+
+    # Every expansion blocking clause ever added, in order; replayed when
+    # resuming from a checkpoint (the expansion solver holds no other state)
+    self.expansion_clauses: List[List[int]] = []
+
+    # Incremental solving context (see push_clauses/pop): one stack level
+    # per pushed clause set. Each level replaces output_gate_id with a
+    # Tseitin-defined gate conjoining the previous output with the pushed
+    # clauses, and carries a guard literal activating the expansion clauses
+    # learned while the level was on top
+    self.push_stack: List[Dict] = []
+    self.expansion_guards: List[int] = []
+
+    # Tseitin definitions of the pushed output gates; pure definitions over
+    # fresh variables, replayed into the fresh counterexample solver when
+    # the decision lists are rebuilt
+    self.pushed_clauses: List[List[int]] = []
+
+    # Iteration numbering starts above this after a checkpoint restore
+    self.start_iteration = 0
+
+    # Optional portfolio of worker processes racing step-1 counterexample
+    # queries; kept in sync through _add_counterexample_clause
+    self.portfolio: Optional[PortfolioSolver] = None
+    if portfolio_size > 0:
+      self.portfolio = PortfolioSolver(matrix, portfolio_size)
     
     # Track last counterexample for debugging (to detect if we see the same one twice)
     self.last_counterexample_existentials: Optional[Set[int]] = None
@@ -146,13 +278,39 @@ class DQBFSolver:
     parts = []
     for lit in sorted(literals, key=abs):
       var_id = abs(lit)
-      var_name = self.id_to_name.get(var_id, f"id{var_id}")
+      var_name = self.names.name_of(var_id)
       if lit > 0:
         parts.append(var_name)
       else:
         parts.append(f"~{var_name}")
     return "[" + ", ".join(parts) + "]"
-  
+
+  def _add_expansion_clause(self, clause: List[int]) -> None:
+    """Add a blocking clause to the expansion solver (and the checkpoint log).
+
+    Inside a pushed context the clause may have been derived using the
+    pushed clauses, so it is guarded by the top level's guard literal and
+    only active while that level remains pushed.
+
+    Args:
+      clause: The clause over expansion variables to add
+    """
+    if self.push_stack:
+      clause = clause + [-self.push_stack[-1]['expansion_guard']]
+    self.expansion_solver.add_clause(clause)
+    self.expansion_clauses.append(clause)
+
+  def _add_counterexample_clause(self, clause: List[int]) -> None:
+    """Add a clause to the counterexample solver and any portfolio workers.
+
+    Args:
+      clause: The clause to add
+    """
+    self.counterexample_solver.add_clause(clause)
+    self.clauses_since_compaction += 1
+    if self.portfolio is not None:
+      self.portfolio.add_clause(clause)
+
   def init_model(self, existential_var_id: int) -> None:
     """Initialize an ordered decision list model for an existential variable.
     
@@ -179,45 +337,48 @@ class DQBFSolver:
     # Get the existential variable name for naming auxiliary variables
     exist_name = self.id_to_name.get(existential_var_id, f"var{existential_var_id}")
     
+    # No premise rules yet for this existential
+    self.rule_premises[existential_var_id] = []
+
     # Create initial value variable (value_1)
     value_var_1 = self.counter.increase()
     self.value_vars[existential_var_id] = value_var_1
-    self.id_to_name[value_var_1] = f"{exist_name}_value_1"
-    
-    # Add to the list of all value variables (index 1 = first value)
-    self.all_value_vars.append((existential_var_id, value_var_1, 1))
-    
+    self.assumption_manager.set_slot(('value', existential_var_id), value_var_1)
+
     # Create initial "no rule fired up to 0" variable
     no_rule_fired_0 = self.counter.increase()
     self.no_rule_fired_vars[existential_var_id] = no_rule_fired_0
-    self.id_to_name[no_rule_fired_0] = f"{exist_name}_nofired_0"
-    
-    # Add to the list of all no_rule_fired variables (index 0 = before any rules)
-    self.all_no_rule_fired_vars.append((existential_var_id, no_rule_fired_0, 0))
-    
+
     # Create "rule fires" variable for rule 1
     fires_var_1 = self.counter.increase()
     self.rule_fire_vars[existential_var_id] = fires_var_1
-    self.id_to_name[fires_var_1] = f"{exist_name}_fire_1"
-    
-    # Add to the list of all rule fire variables (initial rule has empty premise)
-    self.all_rule_fire_vars.append((existential_var_id, fires_var_1, "default"))
+    self.assumption_manager.set_slot(('fire', existential_var_id), fires_var_1)
+
+    # Register rule 1 (the initial default rule with open premise)
+    self.rules[existential_var_id] = [RuleRecord(fires_var_1, no_rule_fired_0, value_var_1)]
+
+    # Register lazy names; display strings are only built when requested
+    self.names.register_value(value_var_1, existential_var_id, 1)
+    self.names.register_no_rule_fired(no_rule_fired_0, existential_var_id, 0)
+    self.names.register_fire(fires_var_1, existential_var_id, 1)
 
     # Add unit clause: no rule up to and including 0 fires
     clause1 = [no_rule_fired_0]
-    self.counterexample_solver.add_clause(clause1)
-    logging.debug(f"Added clause (init {exist_name}): {self._format_literals(clause1)}")
-    
+    self._add_counterexample_clause(clause1)
+
     # Add clauses: if no rule up to 0 fires (~no_rule_fired_0 is true, meaning no_rule_fired_0 is false),
     # then existential_var <=> value_var_0
     # equivalence: (a <=> b) = (a => b) AND (b => a) = (-a OR b) AND (a OR -b)
     clause2 = [-no_rule_fired_0, -fires_var_1, -existential_var_id, value_var_1]
-    self.counterexample_solver.add_clause(clause2)
-    logging.debug(f"Added clause (init {exist_name}): {self._format_literals(clause2)}")
-    
+    self._add_counterexample_clause(clause2)
+
     clause3 = [-no_rule_fired_0, -fires_var_1, existential_var_id, -value_var_1]
-    self.counterexample_solver.add_clause(clause3)
-    logging.debug(f"Added clause (init {exist_name}): {self._format_literals(clause3)}")
+    self._add_counterexample_clause(clause3)
+
+    self.instr.count('clauses_added', 3)
+    if self.instr.trace_enabled:
+      for clause in (clause1, clause2, clause3):
+        logging.debug(f"Added clause (init {exist_name}): {self._format_literals(clause)}")
   
   def set_default_value(self, existential_var_id: int, value: bool) -> None:
     """Set the default value for an existential variable's decision list.
@@ -237,7 +398,9 @@ class DQBFSolver:
       raise ValueError(f"Variable {existential_var_id} has not been initialized. Call init_model first.")
     
     current_value_var = self.value_vars[existential_var_id]
-    self.value_vars[existential_var_id] = current_value_var if value else -current_value_var
+    new_value_var = current_value_var if value else -current_value_var
+    self.value_vars[existential_var_id] = new_value_var
+    self.assumption_manager.set_slot(('value', existential_var_id), new_value_var)
   
   def add_rule(self, existential_var_id: int, premise: List[int], conclusion: bool, value_var: Optional[int] = None) -> None:
     """Add a new rule to the decision list for an existential variable.
@@ -273,103 +436,97 @@ class DQBFSolver:
     
     # Get the existential variable name for naming auxiliary variables
     exist_name = self.id_to_name.get(existential_var_id, f"var{existential_var_id}")
-    
-    # Determine the rule number by parsing the current fire variable name
-    # Extract rule number from name like "var_fire_N"
-    current_fire_name = self.id_to_name.get(abs(this_rule_fired), "")
-    try:
-      rule_num = int(current_fire_name.split("_fire_")[-1]) + 1
-    except (ValueError, IndexError):
-      rule_num = 2  # Default to 2 if parsing fails
-    
+
+    # The new rule's number is one past the current (default) rule's position
+    records = self.rules[existential_var_id]
+    rule_num = len(records) + 1
+
     # Create new variables
     next_rule_fired = self.counter.increase()
     this_no_rule_fired = self.counter.increase()
     next_value_var = self.counter.increase()
-    
+
     # Add to tracking structures
     self.rule_fire_vars[existential_var_id] = next_rule_fired
     self.no_rule_fired_vars[existential_var_id] = this_no_rule_fired
     self.value_vars[existential_var_id] = next_value_var
-    
-    # Create a readable name for the premise
-    premise_name = self._format_literals(premise) if premise else "true"
-    
-    # Update the name of this_rule_fired to reflect the premise it now represents
-    # (it was previously the "default" but is now being used for this specific rule)
-    self.id_to_name[abs(this_rule_fired)] = f"{exist_name}_fire_{rule_num - 1}_premise_{premise_name}"
-    
-    # Update the tracking list entry for this rule fire variable
-    # Find and update the entry that had "default" as the premise
-    for i, (eid, fid, pname) in enumerate(self.all_rule_fire_vars):
-      if eid == existential_var_id and fid == this_rule_fired:
-        self.all_rule_fire_vars[i] = (eid, fid, premise_name)
-        break
-    
-    # Add names for the new variables
-    self.id_to_name[next_rule_fired] = f"{exist_name}_fire_{rule_num}"
-    self.id_to_name[this_no_rule_fired] = f"{exist_name}_nofired_{rule_num - 1}"
-    self.id_to_name[next_value_var] = f"{exist_name}_value_{rule_num}"
-    
-    # Count how many rules exist for this existential (length of matching entries in all_rule_fire_vars)
-    rule_index = sum(1 for eid, _, _ in self.all_rule_fire_vars if eid == existential_var_id)
-    
-    # Add the new default rule fire variable to the tracking list
-    self.all_rule_fire_vars.append((existential_var_id, next_rule_fired, "default"))
-    
-    # Add this no_rule_fired variable to the tracking list
-    self.all_no_rule_fired_vars.append((existential_var_id, this_no_rule_fired, rule_index))
-    
-    # Add the new value variable to the tracking list
-    self.all_value_vars.append((existential_var_id, next_value_var, rule_num))
-    
+    self.assumption_manager.set_slot(('fire', existential_var_id), next_rule_fired)
+    self.assumption_manager.set_slot(('value', existential_var_id), next_value_var)
+
+    # The previous default rule now represents this specific premise; the new
+    # variables form the next open default rule. The premise tuple is shared
+    # with the name table so no literal list is stored twice
+    premise_tuple = tuple(premise)
+    records[-1].premise = premise_tuple
+    records.append(RuleRecord(next_rule_fired, this_no_rule_fired, next_value_var))
+
+    # Register lazy names; display strings are only built when requested
+    self.names.set_fire_premise(abs(this_rule_fired), premise_tuple)
+    self.names.register_fire(next_rule_fired, existential_var_id, rule_num)
+    self.names.register_no_rule_fired(this_no_rule_fired, existential_var_id, rule_num - 1)
+    self.names.register_value(next_value_var, existential_var_id, rule_num)
+
+    trace_enabled = self.instr.trace_enabled
+    rule_clauses = []
+
     # Define this_rule_fired
     for lit in premise:
       clause = [-this_rule_fired, lit]
-      self.counterexample_solver.add_clause(clause)
-      logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause)}")
+      self._add_counterexample_clause(clause)
+      if trace_enabled:
+        rule_clauses.append(clause)
     clause = [-lit for lit in premise] + [this_rule_fired]
-    self.counterexample_solver.add_clause(clause)
-    logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause)}")
-    
+    self._add_counterexample_clause(clause)
+
     # Define next_no_rule_fired
     clause1 = [-this_no_rule_fired, previous_no_rule_fired]
-    self.counterexample_solver.add_clause(clause1)
-    logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause1)}")
-    
+    self._add_counterexample_clause(clause1)
+
     clause2 = [-this_no_rule_fired, -this_rule_fired]
-    self.counterexample_solver.add_clause(clause2)
-    logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause2)}")
-    
+    self._add_counterexample_clause(clause2)
+
     clause3 = [this_no_rule_fired, -previous_no_rule_fired, this_rule_fired]
-    self.counterexample_solver.add_clause(clause3)
-    logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause3)}")
-    
+    self._add_counterexample_clause(clause3)
+
     # Clause 3: if rule fires and no previous rule fired, existential_var <=> value_i
     clause4 = [-next_rule_fired, -this_no_rule_fired, -existential_var_id, next_value_var]
-    self.counterexample_solver.add_clause(clause4)
-    logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause4)}")
-    
+    self._add_counterexample_clause(clause4)
+
     clause5 = [-next_rule_fired, -this_no_rule_fired, existential_var_id, -next_value_var]
-    self.counterexample_solver.add_clause(clause5)
-    logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause5)}")
-    
+    self._add_counterexample_clause(clause5)
+
+    if trace_enabled:
+      rule_clauses.extend([clause, clause1, clause2, clause3, clause4, clause5])
+
+    clauses_added = len(premise) + 6
+
     # Clause 4: Handle conclusion based on whether value_var is provided
     if value_var is None:
       # Add value_i (or -value_i) as permanent assumption based on conclusion
       conclusion_lit = this_value_var if conclusion else -this_value_var
       self.permanent_assumptions.append(conclusion_lit)
-      logging.debug(f"Added permanent assumption for {exist_name}: {self._format_literals([conclusion_lit])}")
+      self.assumption_manager.add_permanent(conclusion_lit)
+      if trace_enabled:
+        logging.debug(f"Added permanent assumption for {exist_name}: {self._format_literals([conclusion_lit])}")
     else:
       # Add equivalence clauses: this_value_var <=> value_var
       # (a <=> b) = (a => b) AND (b => a) = (-a OR b) AND (a OR -b)
       clause6 = [-this_value_var, value_var]
-      self.counterexample_solver.add_clause(clause6)
-      logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause6)}")
-      
+      self._add_counterexample_clause(clause6)
+
       clause7 = [this_value_var, -value_var]
-      self.counterexample_solver.add_clause(clause7)
-      logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(clause7)}")
+      self._add_counterexample_clause(clause7)
+
+      clauses_added += 2
+      if trace_enabled:
+        rule_clauses.extend([clause6, clause7])
+
+    self.instr.count('clauses_added', clauses_added)
+    self.instr.count('rules_added')
+
+    if trace_enabled:
+      for rule_clause in rule_clauses:
+        logging.debug(f"Added clause (rule {rule_num} for {exist_name}): {self._format_literals(rule_clause)}")
   
   def get_expansion_variable(self, existential_var_id: int, assignment: List[int]) -> int:
     """Get or create an expansion variable for an existential variable under a universal assignment.
@@ -392,56 +549,51 @@ class DQBFSolver:
     """
     if existential_var_id not in self.existential_var_ids:
       raise ValueError(f"Variable ID {existential_var_id} is not an existential variable")
-    
-    # Get the dependency set for this existential variable
-    dep_set = set(self.dependencies_by_id.get(existential_var_id, []))
-    
-    # Verify that assignment only contains variables from the dependency set
-    assignment_vars = set(abs(lit) for lit in assignment)
-    if not assignment_vars.issubset(dep_set):
-      extra_vars = assignment_vars - dep_set
-      raise ValueError(f"Assignment contains variables not in dependency set: {extra_vars}")
-    
-    # Create a canonical tuple representation of the assignment
-    # Sort literals by absolute value (variable ID) to ensure consistent ordering
-    assignment_tuple = tuple(sorted(assignment, key=abs))
-    
-    # Create the key for the expansion_vars dictionary
-    key = (existential_var_id, assignment_tuple)
-    
-    # Check if we already have an expansion variable for this combination
-    if key in self.expansion_vars:
-      return self.expansion_vars[key]
-    
+
+    # Walk the trie over the fixed dependency order (O(d), no sorting); the
+    # trie raises ValueError if the assignment mentions a variable outside
+    # the dependency set
+    trie = self.expansion_tries[existential_var_id]
+    existing = trie.lookup(assignment)
+    if existing is not None:
+      return existing
+
     # Create a new expansion variable
     expansion_var_id = self.counter.increase()
 
-    # Add to id_to_name for debugging
-    if existential_var_id in self.id_to_name:
-      exist_name = self.id_to_name[existential_var_id]
-      # Create a readable name showing the assignment
-      assignment_str = "_".join(f"{abs(lit)}={'T' if lit > 0 else 'F'}" 
-                                for lit in assignment_tuple)
-      self.id_to_name[expansion_var_id] = f"exp_{exist_name}_{assignment_str}"
-      logging.debug(f"Created expansion variable: {self.id_to_name[expansion_var_id]} (ID={expansion_var_id})")
+    # The canonical sorted tuple is only built on creation, where it is
+    # shared with the lazy name table
+    assignment_tuple = tuple(sorted(assignment, key=abs))
+
+    # Register a lazy name; the assignment tuple is shared with the name
+    # table and the (potentially very long) display string is only built
+    # on demand
+    self.names.register_expansion(expansion_var_id, existential_var_id, assignment_tuple)
+    if self.instr.trace_enabled:
+      logging.debug(f"Created expansion variable: {self.names.name_of(expansion_var_id)} (ID={expansion_var_id})")
     
     # Store the mapping
-    self.expansion_vars[key] = expansion_var_id
+    trie.store(assignment, expansion_var_id)
 
     # Add a rule for the expansion variable
-    self.add_rule(
-      existential_var_id,
-      premise=list(assignment),
-      conclusion=True,
-      value_var=expansion_var_id
-    )
-    
-    # Add to expansion variable set
+    with self.profiler.phase('rule_generation'):
+      self.add_rule(
+        existential_var_id,
+        premise=list(assignment),
+        conclusion=True,
+        value_var=expansion_var_id
+      )
+    
+    # Record the premise rule (priority order matches rule creation order)
+    self.rule_premises[existential_var_id].append((frozenset(assignment), expansion_var_id))
+
+    # Add to expansion variable set and kind index
     self.expansion_vars_set.add(expansion_var_id)
+    self.kind_index.mark(expansion_var_id, KIND_EXPANSION)
     
     return expansion_var_id
   
-  def get_counterexample(self) -> Tuple[bool, Optional[Tuple[List[int], List[int]]]]:
+  def get_counterexample(self, blocking_assumptions: Optional[List[int]] = None) -> Tuple[bool, Optional[Tuple[List[int], List[int]]]]:
     """Get a counterexample by finding failed assumptions.
     This method:
     1. Checks if the formula is satisfiable with negated output gate
@@ -449,137 +601,314 @@ class DQBFSolver:
     3. Checks that the formula is UNSAT with this assignment and unnegated output
     4. Extracts the failed assumptions (core) from the UNSAT check
     5. Returns the failed assumptions from existential literals, and the full universal assignment
+
+    Args:
+      blocking_assumptions: Optional selector literals activating temporary
+            blocking clauses (used by get_counterexamples for batch extraction)
     """
     # Step 1: Try to satisfy with negated output gate, rule fire variables, and value variables
     negated_output = -self.output_gate_id
-    
-    # Build assumptions: negated output + permanent assumptions + rule fire vars + current value vars
+
+    # Build assumptions: negated output + the persistently maintained vector
+    # (permanent assumptions, rule fire/value slots, expansion assignment)
     assumptions_step1 = [negated_output]
-    assumptions_step1.extend(self.permanent_assumptions)
-    
-    # Add all rule fire variables as assumptions
-    assumptions_step1.extend(self.rule_fire_vars.values())
-    
-    # Add all current value variables as assumptions
-    assumptions_step1.extend(self.value_vars.values())
+    if blocking_assumptions:
+      assumptions_step1.extend(blocking_assumptions)
+    assumptions_step1.extend(self.assumption_manager.base_literals())
+    assumptions_step1.extend(self.expansion_store.literals())
 
-    # Add expansion variable assignment
-    assumptions_step1.extend(self.expansion_variable_assignment)
+    if self.instr.trace_enabled:
+      logging.debug(f"Solving with {len(assumptions_step1)} assumptions:")
+      logging.debug(f"  Assumptions: {self._format_literals(assumptions_step1)}")
 
-    logging.debug(f"Solving with {len(assumptions_step1)} assumptions:")
-    logging.debug(f"  Assumptions: {self._format_literals(assumptions_step1)}")
+    self.instr.count('sat_calls')
+    with self.profiler.phase('step1_search', sat_call=True):
+      if self.portfolio is not None:
+        # Race the query across the portfolio; the winner's model is returned
+        result, model = self.portfolio.solve(assumptions_step1)
+      else:
+        result = self.counterexample_solver.solve(assumptions=assumptions_step1)
+        model = self.counterexample_solver.get_model() if result else None
 
-    result = self.counterexample_solver.solve(assumptions=assumptions_step1)
-    
     if not result:
       # No counterexample found (UNSAT with negated output)
       logging.debug("No counterexample found (formula proven correct)")
       return (False, None)
-    
-    # Step 2: Get the satisfying assignment and restrict to existential and universal variables
-    model = self.counterexample_solver.get_model()
 
+    # Step 2: Restrict the satisfying assignment to existential and universal variables
     # Get universal and existential literals only
-    counterexample_universals = [lit for lit in model if abs(lit) in self.universal_var_ids]
-    counterexample_existentials = [lit for lit in model if abs(lit) in self.existential_var_ids]
-    
-    logging.debug(f"Found potential counterexample:")
-    logging.debug(f"  Existential assignment: {self._format_literals(counterexample_existentials)}")
-    logging.debug(f"  Universal assignment: {self._format_literals(counterexample_universals)}")
-    
-    # Log rule fire and no_rule_fired variables grouped by existential variable
-    for exist_id in self.existential_var_ids:
-      exist_name = self.id_to_name.get(exist_id, f"id{exist_id}")
-      logging.debug(f"  {exist_name}:")
-      
-      # Log no_rule_fired variables for this existential
-      for eid, no_rule_fired_var_id, rule_index in self.all_no_rule_fired_vars:
-        if eid == exist_id:
-          no_rule_fired_name = self.id_to_name.get(no_rule_fired_var_id, f"id{no_rule_fired_var_id}")
-          # Find this variable's assignment in the model
-          for lit in model:
-            if abs(lit) == no_rule_fired_var_id:
-              value = lit > 0
-              logging.debug(f"    {no_rule_fired_name} (after {rule_index} rules) = {value}")
-              break
-      
-      # Log rule fire variables for this existential
-      for eid, fire_var_id, premise_name in self.all_rule_fire_vars:
-        if eid == exist_id:
-          fire_var_name = self.id_to_name.get(fire_var_id, f"id{fire_var_id}")
-          # Find this variable's assignment in the model
-          for lit in model:
-            if abs(lit) == fire_var_id:
-              value = lit > 0
-              logging.debug(f"    {fire_var_name} (premise: {premise_name}) = {value}")
-              break
-      
-      # Log value variables for this existential
-      for eid, value_var_id, value_index in self.all_value_vars:
-        if eid == exist_id:
-          value_var_name = self.id_to_name.get(abs(value_var_id), f"id{abs(value_var_id)}")
-          # Find this variable's assignment in the model
-          for lit in model:
-            if abs(lit) == abs(value_var_id):
-              value = lit > 0
-              # Note: value_var_id might be negated to represent False
-              if value_var_id < 0:
-                value = not value
-              logging.debug(f"    {value_var_name} (for rule {value_index}) = {value}")
-              break
+    counterexample_universals, counterexample_existentials, _ = self.kind_index.partition_model(model)
+
+    if self.instr.trace_enabled:
+      self._trace_counterexample_state(model, counterexample_universals, counterexample_existentials)
 
     # Step 3: Call solve again with restricted assignment and unnegated output gate
     unnegated_output = self.output_gate_id
     assumptions = counterexample_universals + counterexample_existentials + [unnegated_output]
 
-    result2 = self.counterexample_solver.solve(assumptions=assumptions)
-    
+    self.instr.count('sat_calls')
+    with self.profiler.phase('step2_verify', sat_call=True):
+      result2 = self.counterexample_solver.solve(assumptions=assumptions)
+
     # Assert that this call is UNSAT
     assert not result2, "Second solve call should be UNSAT but returned SAT"
-    
+
     # Step 4: Extract failed existential assumptions
     core = self.counterexample_solver.get_core()
     core = [] if core is None else core
     existential_core = [lit for lit in core if abs(lit) in self.existential_var_ids]
-    
-    logging.debug(f"Counterexample verified:")
-    logging.debug(f"  Existential core: {self._format_literals(existential_core)}")
+
+    if self.instr.trace_enabled:
+      logging.debug(f"Counterexample verified:")
+      logging.debug(f"  Existential core: {self._format_literals(existential_core)}")
 
     return (True, (existential_core, counterexample_universals))
-  
+
+  def _trace_counterexample_state(
+    self,
+    model: List[int],
+    counterexample_universals: List[int],
+    counterexample_existentials: List[int]
+  ) -> None:
+    """Dump the decision-list state of a counterexample model (debug only).
+
+    This walks every rule fire, no_rule_fired, and value variable against the
+    full model and is far too expensive for the hot path; callers must guard
+    the call with instr.trace_enabled.
+
+    Args:
+      model: Full satisfying assignment from the counterexample solver
+      counterexample_universals: Universal literals of the counterexample
+      counterexample_existentials: Existential literals of the counterexample
+    """
+    logging.debug(f"Found potential counterexample:")
+    logging.debug(f"  Existential assignment: {self._format_literals(counterexample_existentials)}")
+    logging.debug(f"  Universal assignment: {self._format_literals(counterexample_universals)}")
+
+    # Map variable IDs to their truth values for O(1) lookups below
+    model_values = {abs(lit): lit > 0 for lit in model}
+
+    # Log the decision-list state for each existential variable, rule by rule
+    for exist_id in self.existential_var_ids:
+      exist_name = self.id_to_name.get(exist_id, f"id{exist_id}")
+      logging.debug(f"  {exist_name}:")
+
+      for rule_index, record in enumerate(self.rules.get(exist_id, []), start=1):
+        if record.premise is None:
+          premise_name = "default"
+        else:
+          premise_name = self._format_literals(list(record.premise)) if record.premise else "true"
+
+        no_rule_fired_name = self.names.name_of(record.no_rule_fired_var)
+        fire_var_name = self.names.name_of(record.fire_var)
+        value_var_name = self.names.name_of(abs(record.value_var))
+
+        if record.no_rule_fired_var in model_values:
+          logging.debug(f"    {no_rule_fired_name} (after {rule_index - 1} rules) = {model_values[record.no_rule_fired_var]}")
+        if record.fire_var in model_values:
+          logging.debug(f"    {fire_var_name} (premise: {premise_name}) = {model_values[record.fire_var]}")
+        if abs(record.value_var) in model_values:
+          value = model_values[abs(record.value_var)]
+          # Note: value_var might be negated to represent False
+          if record.value_var < 0:
+            value = not value
+          logging.debug(f"    {value_var_name} (for rule {rule_index}) = {value}")
+
+  def get_counterexamples(self, max_count: int) -> List[Tuple[List[int], List[int]]]:
+    """Extract up to max_count diverse counterexamples in one batch.
+
+    Each found counterexample's universal assignment is blocked for the rest of
+    the batch through a selector-guarded clause: the clause is only active
+    while its selector literal is assumed, so once the batch ends the selectors
+    are never assumed again and the solver is free to satisfy the clauses by
+    setting them to false. This amortizes the per-call assumption setup across
+    several refinements without permanently constraining the solver.
+
+    Args:
+      max_count: Maximum number of counterexamples to extract (at least 1)
+
+    Returns:
+      List of (existential_core, universal_assignment) tuples; empty if no
+      counterexample exists (the formula is correct under the current model)
+    """
+    counterexamples: List[Tuple[List[int], List[int]]] = []
+    batch_selectors: List[int] = []
+
+    while len(counterexamples) < max_count:
+      has_counterexample, counterexample = self.get_counterexample(blocking_assumptions=batch_selectors)
+
+      if not has_counterexample:
+        # No (further) counterexample under the current blocking set
+        break
+
+      counterexamples.append(counterexample)
+
+      if len(counterexamples) == max_count:
+        break
+
+      # Temporarily block this universal assignment for the rest of the batch
+      _, universal_assignment = counterexample
+      selector = self.counter.increase()
+      self._add_counterexample_clause([-selector] + [-lit for lit in universal_assignment])
+      batch_selectors.append(selector)
+
+    if batch_selectors:
+      logging.debug(f"Batch extraction found {len(counterexamples)} counterexamples")
+
+    return counterexamples
+
+  def minimize_premise(self, exist_lit: int, dep_literals: List[int]) -> List[int]:
+    """Compute a generalized rule premise for one failing existential literal.
+
+    The premise of a new rule may only be shortened when the matrix itself
+    forces the opposite value of the existential variable on every extension of
+    the shortened assignment; otherwise a rule with a partial premise would fix
+    the variable to a constant on a whole region of the dependency space and
+    the expansion abstraction could report UNSAT for satisfiable formulas.
+
+    This method therefore checks whether the counterexample's assignment to the
+    variable's own dependencies already refutes the failing literal on its own
+    (i.e. matrix + assignment + exist_lit + unnegated output is UNSAT). If so,
+    the assignment is shrunk with assumption-based core extraction followed by
+    deletion-based shrinking, and every extension of the result provably forces
+    the variable to the opposite value. If not, the full assignment to the
+    dependencies is returned, which reproduces a point rule as before.
+
+    Args:
+      exist_lit: The failing existential literal from the counterexample
+      dep_literals: The counterexample's universal assignment restricted to
+          the variable's dependencies (computed once per dependency handle
+          in analyze_counterexample)
+
+    Returns:
+      A list of universal literals over the variable's dependencies to use as
+      the premise of the new rule
+    """
+    exist_id = abs(exist_lit)
+    dep_set = self.dep_table.set_of(self.dep_handles[exist_id])
+
+    fixed_assumptions = [exist_lit, self.output_gate_id]
+
+    self.instr.count('sat_calls')
+    with self.profiler.phase('premise_minimization', sat_call=True):
+      forced = not self.counterexample_solver.solve(assumptions=dep_literals + fixed_assumptions)
+    if not forced:
+      # The failing value is not forced by this variable's dependencies alone
+      # (the conflict involves other existentials); keep the full point premise
+      logging.debug(f"    Premise not generalizable (conflict is not local)")
+      return dep_literals
+
+    # Restrict to the literals the solver actually used
+    core = self.counterexample_solver.get_core()
+    core = [] if core is None else core
+    candidates = [lit for lit in core if abs(lit) in dep_set]
+
+    # Deletion-based shrinking: try dropping one literal at a time
+    index = 0
+    while index < len(candidates):
+      trial = candidates[:index] + candidates[index + 1:]
+      self.instr.count('sat_calls')
+      with self.profiler.phase('premise_minimization', sat_call=True):
+        needed = self.counterexample_solver.solve(assumptions=trial + fixed_assumptions)
+      if needed:
+        # Literal is necessary for the refutation; keep it
+        index += 1
+      else:
+        # Literal is redundant; keep only what the new core needs
+        core = self.counterexample_solver.get_core()
+        core = [] if core is None else core
+        core_set = set(core)
+        candidates = [lit for lit in trial if lit in core_set]
+
+    logging.debug(f"    Minimized premise from {len(dep_literals)} to {len(candidates)} literals")
+    return candidates
+
   def analyze_counterexample(self, existential_literals: List[int], universal_literals: List[int]) -> None:
     """Analyze a counterexample to refine the model.
-    
+
+    For each existential literal in the counterexample, the blocking clause must
+    constrain the expansion variable of the rule that actually produced the
+    literal's value. Rules earlier in a decision list take priority, so the
+    firing rule is the first one (in creation order) whose premise is satisfied
+    by the universal assignment. Only when no premise rule fired (i.e. the
+    default produced the value) is a new rule learned; its premise is
+    generalized via minimize_premise so that it covers as many counterexamples
+    as soundly possible.
+
     Args:
       existential_literals: List of existential variable literals from the counterexample
       universal_literals: List of universal variable literals from the counterexample
     """
-    logging.debug(f"Analyzing counterexample:")
-    logging.debug(f"  Existential literals: {existential_literals}")
-    logging.debug(f"  Universal literals: {universal_literals}")
-    
+    universal_set = set(universal_literals)
+
+    if self.instr.trace_enabled:
+      logging.debug(f"Analyzing counterexample:")
+      logging.debug(f"  Existential literals: {existential_literals}")
+      logging.debug(f"  Universal literals: {universal_literals}")
+
+    # The universal assignment restricted to a dependency set is the same for
+    # every existential sharing the set; filter once per distinct handle
+    dep_literals_by_handle: Dict[int, List[int]] = {}
+
     expansion_clause = []
     for exist_lit in existential_literals:
       exist_id = abs(exist_lit)
-      exist_name = self.id_to_name.get(exist_id, exist_id)
-      assignment = [lit for lit in universal_literals if abs(lit) in self.dependencies_by_id.get(exist_id, [])]
-      
-      logging.debug(f"  Processing {exist_name}:")
-      logging.debug(f"    Universal assignment: {self._format_literals(assignment)}")
-      
-      expansion_var = self.get_expansion_variable(exist_id, assignment)
-      
+
+      if self.instr.trace_enabled:
+        logging.debug(f"  Processing {self.id_to_name.get(exist_id, exist_id)}:")
+
+      # Find the rule that produced this value: the first rule in priority
+      # order whose premise holds under the (full) universal assignment
+      fired_expansion_var = None
+      for premise, expansion_var in self.rule_premises.get(exist_id, []):
+        if premise <= universal_set:
+          fired_expansion_var = expansion_var
+          break
+
+      if fired_expansion_var is None:
+        # The default value produced this literal: learn a new rule with a
+        # generalized (or, failing that, full point) premise. Capture the
+        # default before the new rule resets the value-variable chain
+        current_default = self.value_vars[exist_id] > 0
+        handle = self.dep_handles[exist_id]
+        dep_literals = dep_literals_by_handle.get(handle)
+        if dep_literals is None:
+          dep_set = self.dep_table.set_of(handle)
+          dep_literals = [lit for lit in universal_literals if abs(lit) in dep_set]
+          dep_literals_by_handle[handle] = dep_literals
+
+        assignment = self.minimize_premise(exist_lit, dep_literals)
+
+        if self.instr.trace_enabled:
+          logging.debug(f"    Universal assignment (premise): {self._format_literals(assignment)}")
+
+        fired_expansion_var = self.get_expansion_variable(exist_id, assignment)
+
+        if self.polarity is not None:
+          # Majority over recent counterexamples, with hysteresis against
+          # thrashing on oscillating instances
+          self.polarity.record(exist_id, exist_lit < 0)
+          new_default = self.polarity.preferred_default(exist_id, current_default)
+        else:
+          # Flip the default away from the failing polarity
+          new_default = exist_lit < 0
+        if new_default != current_default:
+          self.instr.count('default_flips')
+        self.set_default_value(exist_id, new_default)
+        logging.debug(f"    Setting default value to {new_default}")
+      else:
+        if self.instr.trace_enabled:
+          logging.debug(f"    Covered by existing rule (expansion variable ID={fired_expansion_var}, "
+                        f"assumed value={self.expansion_store.value_of(fired_expansion_var)})")
+
       if exist_lit > 0:
-        expansion_clause.append(-expansion_var)
-        self.set_default_value(exist_id, False)
-        logging.debug(f"    Setting default value to False")
+        expansion_clause.append(-fired_expansion_var)
       else:
-        expansion_clause.append(expansion_var)
-        self.set_default_value(exist_id, True)
-        logging.debug(f"    Setting default value to True")
+        expansion_clause.append(fired_expansion_var)
 
-    logging.debug(f"Adding expansion clause (blocking clause): {self._format_literals(expansion_clause)}")
-    self.expansion_solver.add_clause(expansion_clause)
+    if self.instr.trace_enabled:
+      logging.debug(f"Adding expansion clause (blocking clause): {self._format_literals(expansion_clause)}")
+    self._add_expansion_clause(expansion_clause)
   
   def compute_model_functions(self, universal_literals: List[int]) -> Optional[List[int]]:
     """Compute the outputs of the model functions for a given universal assignment.
@@ -595,37 +924,20 @@ class DQBFSolver:
       List of existential literals representing the model function outputs,
       or None if the model is unsatisfiable with this universal assignment
     """
-    # Build assumptions: permanent assumptions + rule fire vars + current value vars + universal assignment
-    # We add only the expansion variable assignments that are relevant to this universal assignment
-    assumptions = []
-    assumptions.extend(self.permanent_assumptions)
-    assumptions.extend(self.rule_fire_vars.values())
-    assumptions.extend(self.value_vars.values())
+    # Build assumptions: the maintained base vector (permanent assumptions,
+    # rule fire/value slots) + the expansion assignment + the universal
+    # assignment. All expansion variable values are assumed; rules whose
+    # premises do not hold under this universal assignment cannot fire, so
+    # the extra assumptions are vacuous but harmless
+    assumptions = list(self.assumption_manager.base_literals())
+    assumptions.extend(self.expansion_store.literals())
     assumptions.extend(universal_literals)
     
-    # For each existential variable, check if there's an expansion variable for this universal assignment
-    # and add its value from expansion_variable_assignment
-    for exist_id in self.existential_var_ids:
-      # Get the dependency set for this existential variable
-      dep_set = self.dependencies_by_id.get(exist_id, set())
-      
-      # Extract the assignment to dependent universal variables
-      assignment = [lit for lit in universal_literals if abs(lit) in dep_set]
-      assignment_tuple = tuple(sorted(assignment, key=abs))
-      
-      # Check if we have an expansion variable for this combination
-      key = (exist_id, assignment_tuple)
-      if key in self.expansion_vars:
-        exp_var_id = self.expansion_vars[key]
-        # Find the value of this expansion variable in expansion_variable_assignment
-        for lit in self.expansion_variable_assignment:
-          if abs(lit) == exp_var_id:
-            assumptions.append(lit)
-            break
-    
-    logging.debug(f"Computing model functions for universal assignment: {self._format_literals(universal_literals)}")
-    logging.debug(f"  Using {len(assumptions)} assumptions: {self._format_literals(assumptions)}")
-    
+    if self.instr.trace_enabled:
+      logging.debug(f"Computing model functions for universal assignment: {self._format_literals(universal_literals)}")
+      logging.debug(f"  Using {len(assumptions)} assumptions: {self._format_literals(assumptions)}")
+
+    self.instr.count('sat_calls')
     result = self.counterexample_solver.solve(assumptions=assumptions)
     
     if not result:
@@ -638,7 +950,7 @@ class DQBFSolver:
     
     # Get the model and extract existential variable assignments
     model = self.counterexample_solver.get_model()
-    existential_assignment = [lit for lit in model if abs(lit) in self.existential_var_ids]
+    existential_assignment = self.kind_index.filter_kind(model, KIND_EXISTENTIAL)
     
     logging.debug(f"  Model function outputs: {self._format_literals(existential_assignment)}")
     return existential_assignment
@@ -687,42 +999,18 @@ class DQBFSolver:
     
     return all_valid
   
-  def solve(self) -> bool:
-    """Solve the DQBF formula.
-    
-    Returns:
-      True if the formula is satisfiable, False otherwise
+  def _analyze_batch(self, counterexamples: List[Tuple[List[int], List[int]]]) -> None:
+    """Analyze a batch of counterexamples, checking for lack of progress.
+
+    Args:
+      counterexamples: (existential_core, universal_assignment) tuples
     """
-    iteration = 0
-    while True:
-      iteration += 1
-      logging.debug(f"\n=== Iteration {iteration} ===")
-      
-      has_counterexample, counterexample = self.get_counterexample()
-      
-      if not has_counterexample:
-        logging.info(f"Formula is SATISFIABLE (after {iteration} iterations)")
-        
-        # Compute and display the model functions for all universal assignments (only in verbose mode)
-        if logging.getLogger().isEnabledFor(logging.DEBUG):
-          logging.info("Computing model functions for all universal assignments:")
-          all_valid = self._enumerate_and_compute_model_functions()
-          
-          if not all_valid:
-            logging.error("ERROR: Cannot compute outputs for some universal assignments")
-            logging.error("This indicates an internal error in the solver")
-            import sys
-            sys.exit(1)
-        
-        return True
-      
-      existential_core, universal_assignment = counterexample
-      
+    for existential_core, universal_assignment in counterexamples:
       # Check if this is the same counterexample as the last one (debugging check)
       current_exist_set = set(existential_core)
       current_univ_set = set(universal_assignment)
-      
-      if (self.last_counterexample_existentials is not None and 
+
+      if (self.last_counterexample_existentials is not None and
           self.last_counterexample_universals is not None):
         if (current_exist_set == self.last_counterexample_existentials and
             current_univ_set == self.last_counterexample_universals):
@@ -732,32 +1020,461 @@ class DQBFSolver:
           logging.error("This indicates the solver is not making progress")
           import sys
           sys.exit(1)
-      
+
       # Store this counterexample for next iteration
       self.last_counterexample_existentials = current_exist_set
       self.last_counterexample_universals = current_univ_set
-      
+
       self.analyze_counterexample(existential_core, universal_assignment)
-      
-      logging.debug(f"Checking expansion solver (with {len(self.expansion_vars)} expansion variables)...")
-      if not self.expansion_solver.solve():
+
+  def compact_decision_lists(self) -> None:
+    """Rebuild the decision lists and the counterexample solver.
+
+    Rules whose premise is subsumed by an earlier (higher-priority) rule's
+    premise can never fire and are dropped; every other rule is replayed
+    into a fresh solver bootstrapped from the matrix, with the same
+    expansion variables and the current default values. This reclaims the
+    state accumulated over many refinements: dead selector-guarded blocking
+    clauses from batch extraction, superseded value-variable chains, and
+    the solver's learnt clauses over them.
+    """
+    # Capture the surviving rules and current defaults per existential
+    survivors: Dict[int, List[Tuple[frozenset, int]]] = {}
+    defaults: Dict[int, bool] = {}
+    dropped = 0
+    for exist_id in self.existential_var_ids:
+      kept: List[Tuple[frozenset, int]] = []
+      for premise, expansion_var in self.rule_premises.get(exist_id, []):
+        if any(earlier <= premise for earlier, _ in kept):
+          # Unreachable: an earlier rule fires whenever this premise holds
+          dropped += 1
+          continue
+        kept.append((premise, expansion_var))
+      survivors[exist_id] = kept
+      defaults[exist_id] = self.value_vars[exist_id] > 0
+
+    # Rebuild from a fresh solver; expansion variables keep their
+    # identities, so the expansion solver and its blocking clauses are
+    # untouched
+    self._reset_decision_lists()
+    self._replay_rules(survivors, defaults)
+    # Measure growth since the rebuild completed, not the rebuild itself:
+    # counting the replayed rules would retrigger compaction every
+    # iteration once the live rules alone reach the interval
+    self.clauses_since_compaction = 0
+
+    self.instr.count('compactions')
+    self.instr.count('compaction_dropped_rules', dropped)
+    logging.debug(f"Compaction rebuilt the decision lists ({dropped} unreachable rules dropped)")
+
+  def _reset_decision_lists(self) -> None:
+    """Discard all decision-list state and start from a fresh counterexample solver."""
+    self.value_vars = {}
+    self.no_rule_fired_vars = {}
+    self.rule_fire_vars = {}
+    self.rule_premises = {}
+    self.rules = {}
+    self.permanent_assumptions = []
+    self.assumption_manager = AssumptionManager()
+    self.names.drop_rule_records()
+    self.counterexample_solver = SAT(bootstrap_with=self.matrix)
+    if self.portfolio is not None:
+      self.portfolio.reset()
+    # Pushed output-gate definitions are part of the current context and
+    # survive the rebuild. The caller zeroes clauses_since_compaction once
+    # the replay that follows is done
+    for clause in self.pushed_clauses:
+      self._add_counterexample_clause(clause)
+
+  def _replay_rules(self, rules: Dict[int, List[Tuple[frozenset, int]]], defaults: Dict[int, bool]) -> None:
+    """Rebuild the decision lists from captured rule and default state.
+
+    Used by compaction and by checkpoint restore: the caller resets the
+    decision-list state first, then this replays each existential's rules
+    (in priority order, with their original expansion variables as value
+    variables) and restores its default value.
+
+    Args:
+      rules: Existential ID -> (premise frozenset, expansion variable) list
+      defaults: Existential ID -> default value
+    """
+    for exist_id in self.existential_var_ids:
+      self.init_model(exist_id)
+      for premise, expansion_var in rules.get(exist_id, []):
+        self.add_rule(exist_id, premise=list(premise), conclusion=True, value_var=expansion_var)
+        self.rule_premises[exist_id].append((premise, expansion_var))
+      self.set_default_value(exist_id, defaults[exist_id])
+
+  def _maybe_compact(self) -> None:
+    """Run compaction when the clause-growth threshold has been reached."""
+    if self.compact_interval and self.clauses_since_compaction >= self.compact_interval:
+      self.compact_decision_lists()
+
+  def push_clauses(self, clauses: List[List[int]]) -> None:
+    """Push a set of clauses onto the incremental context stack.
+
+    The pushed clauses strengthen the specification: a fresh output gate
+    defined as (previous output AND every pushed clause) is Tseitin-encoded
+    into the counterexample solver and replaces output_gate_id, so step 1
+    searches for assignments falsifying the strengthened output (including
+    ones that merely violate a pushed clause) and step 3 verifies against
+    it. Decision lists and expansion clauses learned on earlier variants
+    stay active: strengthening only shrinks the set of winning strategies,
+    so every previously refuted strategy fragment remains refuted.
+    Refinements learned while this level is on top may depend on its
+    clauses and are guarded so pop() can retire them.
+
+    Args:
+      clauses: Clauses over existing variables to conjoin to the current
+               output (e.g. a strengthened specification)
+    """
+    old_output = self.output_gate_id
+
+    # b_i <-> clause_i, then new_output <-> old_output /\ b_1 /\ ... /\ b_m;
+    # pure definitions over fresh variables, so they are harmless to keep
+    # in the solver after the level is popped
+    definitions: List[List[int]] = []
+    clause_vars = []
+    for clause in clauses:
+      clause_var = self.counter.increase()
+      clause_vars.append(clause_var)
+      definitions.append([-clause_var] + list(clause))
+      for lit in clause:
+        definitions.append([clause_var, -lit])
+
+    new_output = self.counter.increase()
+    definitions.append([-new_output, old_output])
+    for clause_var in clause_vars:
+      definitions.append([-new_output, clause_var])
+    definitions.append([new_output, -old_output] + [-v for v in clause_vars])
+
+    for clause in definitions:
+      self._add_counterexample_clause(clause)
+    self.pushed_clauses.extend(definitions)
+
+    expansion_guard = self.counter.increase()
+    self.output_gate_id = new_output
+    self.expansion_guards.append(expansion_guard)
+    self.push_stack.append({
+      'old_output': old_output,
+      'expansion_guard': expansion_guard,
+      'rule_marks': {exist_id: len(self.rule_premises.get(exist_id, []))
+                     for exist_id in self.existential_var_ids},
+    })
+
+    # The progress check must not compare counterexamples across contexts
+    self.last_counterexample_existentials = None
+    self.last_counterexample_universals = None
+    logging.debug(f"Pushed {len(clauses)} clauses (context depth {len(self.push_stack)})")
+
+  def pop(self) -> None:
+    """Pop the most recently pushed clause set.
+
+    The previous output gate is restored; the popped level's gate
+    definitions stay in the solver but are inert once no query assumes its
+    output. Rules and expansion clauses learned while the level was on top
+    used its strengthened output in their derivations and are no longer
+    justified, so the level's expansion guard is forced off and the
+    decision lists are rebuilt without the level's rules (through the same
+    reset/replay helpers compaction uses). Everything learned at lower
+    depths remains active.
+
+    Raises:
+      ValueError: If no clause set is currently pushed
+    """
+    if not self.push_stack:
+      raise ValueError("pop() without a matching push_clauses()")
+    level = self.push_stack.pop()
+    self.expansion_guards.pop()
+    self.output_gate_id = level['old_output']
+
+    # Permanently disable the level's learned expansion clauses
+    self.expansion_solver.add_clause([-level['expansion_guard']])
+    self.expansion_clauses.append([-level['expansion_guard']])
+
+    # Drop the rules learned at this level: their premises may have been
+    # generalized using the popped clauses. Expansion tries are rebuilt so
+    # a later counterexample learns a fresh rule for the same assignment
+    survivors: Dict[int, List[Tuple[frozenset, int]]] = {}
+    defaults: Dict[int, bool] = {}
+    dropped = 0
+    for exist_id in self.existential_var_ids:
+      mark = level['rule_marks'][exist_id]
+      rules = self.rule_premises.get(exist_id, [])
+      survivors[exist_id] = rules[:mark]
+      dropped += len(rules) - mark
+      defaults[exist_id] = self.value_vars[exist_id] > 0
+
+    for exist_id, handle in self.dep_handles.items():
+      trie = ExpansionTrie(self.dep_table.list_of(handle), self.dep_table.level_map(handle))
+      for premise, expansion_var in survivors[exist_id]:
+        trie.store(premise, expansion_var)
+      self.expansion_tries[exist_id] = trie
+
+    self._reset_decision_lists()
+    self._replay_rules(survivors, defaults)
+    self.clauses_since_compaction = 0
+
+    self.last_counterexample_existentials = None
+    self.last_counterexample_universals = None
+    logging.debug(f"Popped context level (depth {len(self.push_stack)}, "
+                  f"{dropped} level rules dropped)")
+
+  def _finish_satisfiable(self, iteration: int) -> bool:
+    """Report a satisfiable result (and, in verbose mode, the model)."""
+    logging.info(f"Formula is SATISFIABLE (after {iteration} iterations)")
+
+    # Compute and display the model functions for all universal assignments (only in verbose mode)
+    if logging.getLogger().isEnabledFor(logging.DEBUG):
+      logging.info("Computing model functions for all universal assignments:")
+      all_valid = self._enumerate_and_compute_model_functions()
+
+      if not all_valid:
+        logging.error("ERROR: Cannot compute outputs for some universal assignments")
+        logging.error("This indicates an internal error in the solver")
+        import sys
+        sys.exit(1)
+
+    return True
+
+  def _update_expansion_assignment(self) -> None:
+    """Pull the expansion solver's latest model into the expansion store."""
+    model = self.expansion_solver.get_model()
+    for lit in self.kind_index.filter_kind(model, KIND_EXPANSION):
+      self.expansion_store.set_literal(lit)
+    logging.debug(f"Expansion model found: {len(self.expansion_store)} expansion variable assignments")
+    if self.instr.trace_enabled:
+      logging.debug(f"  Assignments: {self.expansion_store.literals()}")
+
+  def solve(self) -> bool:
+    """Solve the DQBF formula.
+
+    Returns:
+      True if the formula is satisfiable, False otherwise
+    """
+    if self.pipeline:
+      return self._solve_pipelined()
+
+    iteration = self.start_iteration
+    while True:
+      iteration += 1
+      self.instr.count('iterations')
+      logging.debug(f"\n=== Iteration {iteration} ===")
+
+      counterexamples = self.get_counterexamples(self.batch_size)
+
+      if not counterexamples:
+        return self._finish_satisfiable(iteration)
+
+      with self.profiler.phase('analyze_counterexamples'):
+        self._analyze_batch(counterexamples)
+      self._maybe_compact()
+
+      logging.debug(f"Checking expansion solver (with {len(self.expansion_vars_set)} expansion variables)...")
+      if not self._solve_expansion():
         logging.info(f"Formula is UNSATISFIABLE (after {iteration} iterations)")
         return False
-      
-      model = self.expansion_solver.get_model()
-      self.expansion_variable_assignment = [lit for lit in model if abs(lit) in self.expansion_vars_set]
-      logging.debug(f"Expansion model found: {len(self.expansion_variable_assignment)} expansion variable assignments")
-      logging.debug(f"  Assignments: {self.expansion_variable_assignment}")
+
+      self._update_expansion_assignment()
+      self._maybe_checkpoint(iteration)
+
+  def _maybe_checkpoint(self, iteration: int) -> None:
+    """Save a checkpoint when the iteration interval has been reached."""
+    if (self.checkpoint_path and self.checkpoint_interval and
+        iteration % self.checkpoint_interval == 0):
+      checkpoint.save_checkpoint(self, self.checkpoint_path, iteration)
+
+  def _solve_expansion(self) -> bool:
+    """Run one expansion-abstraction solve with counting and timing."""
+    self.instr.count('expansion_sat_calls')
+    with self.profiler.phase('expansion_solve', sat_call=True):
+      return self.expansion_solver.solve(assumptions=self.expansion_guards)
+
+  def _solve_pipelined(self) -> bool:
+    """Solve with expansion solving and counterexample search overlapped.
+
+    After a batch of counterexamples is analyzed, the expansion-abstraction
+    solve runs on a background thread while this thread speculatively
+    searches for the next batch under the previous expansion assignment.
+    When the new assignment turns out unchanged, the speculative batch is
+    exactly what a fresh search would have found and is used directly;
+    otherwise it is discarded and the search reruns under the new
+    assignment. Since each engine accounts for roughly half the runtime on
+    refinement-heavy instances, a good hit rate overlaps most of it.
+
+    Returns:
+      True if the formula is satisfiable, False otherwise
+    """
+    iteration = self.start_iteration + 1
+    self.instr.count('iterations')
+    logging.debug(f"\n=== Iteration {iteration} (pipelined) ===")
+    counterexamples = self.get_counterexamples(self.batch_size)
+
+    executor = ThreadPoolExecutor(max_workers=1)
+    try:
+      while True:
+        if not counterexamples:
+          return self._finish_satisfiable(iteration)
+
+        with self.profiler.phase('analyze_counterexamples'):
+          self._analyze_batch(counterexamples)
+        self._maybe_compact()
+
+        # Kick off the expansion solve and overlap it with a speculative
+        # counterexample search under the current (old) expansion assignment
+        logging.debug(f"Checking expansion solver (with {len(self.expansion_vars_set)} expansion variables)...")
+        expansion_future = executor.submit(self._solve_expansion)
+
+        previous_assignment = tuple(self.expansion_store.literals())
+        speculative_batch = self.get_counterexamples(self.batch_size)
+
+        if not expansion_future.result():
+          logging.info(f"Formula is UNSATISFIABLE (after {iteration} iterations)")
+          return False
+
+        self._update_expansion_assignment()
+        self._maybe_checkpoint(iteration)
+        iteration += 1
+        self.instr.count('iterations')
+        logging.debug(f"\n=== Iteration {iteration} (pipelined) ===")
+
+        if tuple(self.expansion_store.literals()) == previous_assignment:
+          # Assignment unchanged: the speculative batch is valid as-is
+          self.instr.count('pipeline_hits')
+          counterexamples = speculative_batch
+        else:
+          self.instr.count('pipeline_misses')
+          counterexamples = self.get_counterexamples(self.batch_size)
+    finally:
+      executor.shutdown(wait=True)
   
-  def detect_equivalent_existentials(self) -> Dict[int, List[int]]:
+  def _simulation_signatures(self, evaluator, num_samples: int) -> Dict[int, Tuple[bool, ...]]:
+    """Compute behavior signatures for existentials by random circuit simulation.
+
+    Random assignments to all universal and existential variables are
+    evaluated through the circuit; for every sample that satisfies the
+    output, each existential's value is appended to its signature. Two
+    existentials with the same dependency set can only be equivalent if they
+    take the same value in every satisfying assignment, so differing
+    signatures refute a pair without any SAT call. Samples that falsify the
+    output carry no information and are dropped (shorter signatures just
+    filter less).
+
+    Args:
+      evaluator: Callable mapping {var_id: bool} input assignments to the
+                 output gate's value (e.g. DQCIRParser.evaluate)
+      num_samples: Number of random assignments to simulate
+
+    Returns:
+      Dictionary mapping existential variable IDs to signature tuples
+    """
+    rng = random.Random(0)
+    input_ids = self.universal_var_ids + self.existential_var_ids
+    signatures: Dict[int, List[bool]] = {exist_id: [] for exist_id in self.existential_var_ids}
+
+    satisfying = 0
+    for _ in range(num_samples):
+      assignment = {var_id: rng.random() < 0.5 for var_id in input_ids}
+      if evaluator(assignment):
+        satisfying += 1
+        for exist_id in self.existential_var_ids:
+          signatures[exist_id].append(assignment[exist_id])
+
+    logging.debug(f"Simulation: {satisfying}/{num_samples} samples satisfy the output")
+    return {exist_id: tuple(bits) for exist_id, bits in signatures.items()}
+
+  def warm_start_defaults(self, evaluator, num_samples: int = 256) -> None:
+    """Pick initial default values by random simulation of the circuit.
+
+    Each existential's default is set to its majority value over the
+    satisfying random samples, so the initial decision lists start from
+    the polarity the formula itself prefers instead of an arbitrary True.
+    Purely heuristic: any default is sound, this one just tends to need
+    fewer corrective rules.
+
+    Args:
+      evaluator: Callable mapping {var_id: bool} input assignments to the
+                 output gate's value (e.g. DQCIRParser.evaluate)
+      num_samples: Number of random assignments to simulate
+    """
+    rng = random.Random(0)
+    input_ids = self.universal_var_ids + self.existential_var_ids
+    true_counts = {exist_id: 0 for exist_id in self.existential_var_ids}
+
+    satisfying = 0
+    for _ in range(num_samples):
+      assignment = {var_id: rng.random() < 0.5 for var_id in input_ids}
+      if evaluator(assignment):
+        satisfying += 1
+        for exist_id in self.existential_var_ids:
+          if assignment[exist_id]:
+            true_counts[exist_id] += 1
+
+    if not satisfying:
+      logging.debug("Warm start found no satisfying samples; keeping default True")
+      return
+
+    for exist_id in self.existential_var_ids:
+      self.set_default_value(exist_id, 2 * true_counts[exist_id] >= satisfying)
+    logging.debug(f"Warm-started defaults from {satisfying}/{num_samples} satisfying samples")
+
+  def _check_pairs_parallel(self, candidate_pairs: List[Tuple[int, int]], uf, workers: int) -> None:
+    """Confirm candidate pairs with SAT calls sharded across worker processes.
+
+    Pairs are submitted in waves so that merges from one wave can skip pairs
+    a later wave would otherwise re-check (transitively unified pairs need
+    no SAT call of their own).
+
+    Args:
+      candidate_pairs: (var1_id, var2_id) pairs in group order
+      uf: The union-find structure merges are recorded in
+      workers: Number of worker processes
+    """
+    checker = ParallelPairChecker(self.matrix, self.counter.n, self.output_gate_id, workers)
+    try:
+      # A few tasks per worker and wave balances load against skip potential
+      wave_size = workers * 4
+      for start in range(0, len(candidate_pairs), wave_size):
+        wave = []
+        for var1_id, var2_id in candidate_pairs[start:start + wave_size]:
+          if uf.same_set(var1_id, var2_id):
+            continue
+          wave.append((
+            var1_id,
+            var2_id,
+            list(self.dep_table.list_of(self.dep_handles[var1_id])),
+            list(self.dep_table.list_of(self.dep_handles[var2_id]))
+          ))
+        if not wave:
+          continue
+
+        for var1_id, var2_id, equivalent in checker.check(wave):
+          if equivalent:
+            var1_name = self.id_to_name.get(var1_id, str(var1_id))
+            var2_name = self.id_to_name.get(var2_id, str(var2_id))
+            logging.info(f"  Found equivalent variables: {var1_name} and {var2_name}")
+            uf.union(var1_id, var2_id)
+    finally:
+      checker.close()
+
+  def detect_equivalent_existentials(self, evaluator=None, num_samples: int = 256, workers: int = 0) -> Dict[int, List[int]]:
     """Detect equivalent existential variables.
-    
+
     Two existential variables are equivalent if they have the same dependencies
     and cannot be forced to different values under any assignment to their dependencies.
-    
-    This method groups existentials by the number of dependencies, then for each group,
-    checks pairs of variables to see if they can be different.
-    
+
+    Candidate pairs are limited to existentials with the same dependency set,
+    and, when a circuit evaluator is available, further filtered by random
+    simulation signatures (see _simulation_signatures) so that only pairs the
+    simulation could not tell apart are confirmed with a SAT call.
+
+    Args:
+      evaluator: Optional circuit evaluator (e.g. DQCIRParser.evaluate) used
+                 for the simulation-based filtering stage
+      num_samples: Number of random assignments simulated for the signatures
+      workers: Number of worker processes for the SAT confirmation calls
+               (0 runs them sequentially on one solver)
+
     Returns:
       Dictionary mapping a representative existential variable ID to a list of equivalent
       existential variable IDs (including the representative)
@@ -807,62 +1524,76 @@ class DQBFSolver:
           classes[root].append(elem)
         return classes
 
-    detection_solver = SAT(bootstrap_with=self.matrix)
-    
     # Initialize union-find with all existential variables
     uf = UnionFind(self.existential_var_ids)
-    
-    # Group existentials by number of dependencies
-    by_dep_count: Dict[int, List[int]] = {}
-    for exist_id in self.existential_var_ids:
-      dep_count = len(self.dependencies_by_id_list.get(exist_id, []))
-      if dep_count not in by_dep_count:
-        by_dep_count[dep_count] = []
-      by_dep_count[dep_count].append(exist_id)
-    
-    logging.debug(f"Grouped {len(self.existential_var_ids)} existentials by dependency count:")
-    for dep_count, group in sorted(by_dep_count.items()):
-      logging.debug(f"  {dep_count} dependencies: {len(group)} variables")
-    
-    # For each group with the same dependency count
-    for dep_count, group in sorted(by_dep_count.items()):
-      logging.debug(f"Checking {len(group)} variables with {dep_count} dependencies...")
-      
-      # Check all pairs in this group
+
+    # Group existentials by their interned dependency handle; variables with
+    # different dependencies are never candidates
+    by_handle = self.exist_ids_by_handle
+
+    logging.debug(f"Grouped {len(self.existential_var_ids)} existentials into "
+                  f"{len(by_handle)} dependency-set groups")
+
+    # Refine groups by simulation signatures: existentials that disagree in
+    # some satisfying sample cannot be equivalent
+    if evaluator is not None:
+      signatures = self._simulation_signatures(evaluator, num_samples)
+      refined: Dict[Tuple[int, Tuple[bool, ...]], List[int]] = {}
+      for handle, group in by_handle.items():
+        for exist_id in group:
+          key = (handle, signatures[exist_id])
+          if key not in refined:
+            refined[key] = []
+          refined[key].append(exist_id)
+      candidate_groups = list(refined.values())
+      logging.debug(f"Simulation refined candidates into {len(candidate_groups)} signature classes")
+    else:
+      candidate_groups = list(by_handle.values())
+
+    # Enumerate all candidate pairs (in group order, so transitive merges
+    # can skip later pairs)
+    candidate_pairs: List[Tuple[int, int]] = []
+    for group in candidate_groups:
       for i in range(len(group)):
-        var1_id = group[i]
-        var1_name = self.id_to_name.get(var1_id, str(var1_id))
-        
         for j in range(i + 1, len(group)):
-          var2_id = group[j]
-          var2_name = self.id_to_name.get(var2_id, str(var2_id))
-          
-          # Skip if already in the same equivalence class
-          if uf.same_set(var1_id, var2_id):
-            logging.debug(f"  Skipping {var1_name} and {var2_name}: already equivalent")
-            continue
-          
-          # Get dependencies for both variables (in order)
-          deps1 = self.dependencies_by_id_list.get(var1_id, [])
-          deps2 = self.dependencies_by_id_list.get(var2_id, [])
-          
-          logging.debug(f"  Checking pair: {var1_name} and {var2_name}")
-          logging.debug(f"    {var1_name} deps: {[self.id_to_name.get(d, str(d)) for d in deps1]}")
-          logging.debug(f"    {var2_name} deps: {[self.id_to_name.get(d, str(d)) for d in deps2]}")
-          
-          assumption_variable = self.counter.increase()
-          for dep_var1, dep_var2 in zip(deps1, deps2):
-            detection_solver.add_clause([-assumption_variable, dep_var1, -dep_var2])
-            detection_solver.add_clause([-assumption_variable, -dep_var1, dep_var2])
-
-          detection_solver.add_clause([-assumption_variable, var1_id, var2_id])
-          detection_solver.add_clause([-assumption_variable, -var1_id, -var2_id])
-
-          result = detection_solver.solve(assumptions=[assumption_variable, self.output_gate_id])
-          
-          if not result:
-            logging.info(f"  Found equivalent variables: {var1_name} and {var2_name}")
-            uf.union(var1_id, var2_id)
+          candidate_pairs.append((group[i], group[j]))
+
+    logging.debug(f"Confirming {len(candidate_pairs)} candidate pairs with SAT calls...")
+
+    if workers > 0:
+      self._check_pairs_parallel(candidate_pairs, uf, workers)
+    else:
+      detection_solver = SAT(bootstrap_with=self.matrix)
+      for var1_id, var2_id in candidate_pairs:
+        var1_name = self.id_to_name.get(var1_id, str(var1_id))
+        var2_name = self.id_to_name.get(var2_id, str(var2_id))
+
+        # Skip if already in the same equivalence class
+        if uf.same_set(var1_id, var2_id):
+          logging.debug(f"  Skipping {var1_name} and {var2_name}: already equivalent")
+          continue
+
+        # Get dependencies for both variables (in canonical order)
+        deps1 = self.dep_table.list_of(self.dep_handles[var1_id])
+        deps2 = self.dep_table.list_of(self.dep_handles[var2_id])
+
+        logging.debug(f"  Checking pair: {var1_name} and {var2_name}")
+        logging.debug(f"    {var1_name} deps: {[self.id_to_name.get(d, str(d)) for d in deps1]}")
+        logging.debug(f"    {var2_name} deps: {[self.id_to_name.get(d, str(d)) for d in deps2]}")
+
+        assumption_variable = self.counter.increase()
+        for dep_var1, dep_var2 in zip(deps1, deps2):
+          detection_solver.add_clause([-assumption_variable, dep_var1, -dep_var2])
+          detection_solver.add_clause([-assumption_variable, -dep_var1, dep_var2])
+
+        detection_solver.add_clause([-assumption_variable, var1_id, var2_id])
+        detection_solver.add_clause([-assumption_variable, -var1_id, -var2_id])
+
+        result = detection_solver.solve(assumptions=[assumption_variable, self.output_gate_id])
+
+        if not result:
+          logging.info(f"  Found equivalent variables: {var1_name} and {var2_name}")
+          uf.union(var1_id, var2_id)
     
     # Get final equivalence classes
     equivalence_classes = uf.get_classes()
@@ -879,21 +1610,30 @@ class DQBFSolver:
     return equivalence_classes
               
   
+  def close(self) -> None:
+    """Release external solver resources (portfolio worker processes)."""
+    if self.portfolio is not None:
+      self.portfolio.stop()
+      self.portfolio = None
+
   def get_statistics(self) -> Dict[str, int]:
     """Get statistics about the formula.
     
     Returns:
       Dictionary with formula statistics
     """
-    return {
+    stats = {
       'total_variables': len(self.name_to_id),
       'universal_variables': len(self.universal_vars),
       'existential_variables': len(self.existential_vars),
+      'assumptions': len(self.assumption_manager) + len(self.expansion_store),
       'clauses': len(self.matrix),
       'max_clause_size': max(len(clause) for clause in self.matrix) if self.matrix else 0,
       'avg_clause_size': sum(len(clause) for clause in self.matrix) / len(self.matrix) if self.matrix else 0,
       'max_dependencies': max(len(deps) for deps in self.dependencies.values()) if self.dependencies else 0,
     }
+    stats.update(self.instr.get_counters())
+    return stats
   
   def print_formula_info(self):
     """Print information about the formula."""
@@ -954,6 +1694,34 @@ class DQBFSolver:
     
     print()
   
+def _write_stats_json(path: str, filename: str, result: bool, wall_seconds: float, solver: 'DQBFSolver') -> None:
+  """Write one machine-readable JSON record of a solve run.
+
+  The record carries everything the benchmark runner collects per instance:
+  the result, the solve wall time, the process peak RSS, and the solver's
+  full statistics dictionary (iteration, SAT-call, and rule counters).
+
+  Args:
+    path: Output file path for the JSON record
+    filename: Path of the solved DQCIR instance
+    result: True for satisfiable, False for unsatisfiable
+    wall_seconds: Wall time of the solve() call
+    solver: The DQBFSolver the statistics are read from
+  """
+  import json
+  import resource
+
+  record = {
+    'instance': filename,
+    'result': 'SATISFIABLE' if result else 'UNSATISFIABLE',
+    'wall_seconds': wall_seconds,
+    'peak_rss_kb': resource.getrusage(resource.RUSAGE_SELF).ru_maxrss,
+    'statistics': solver.get_statistics(),
+  }
+  with open(path, 'w') as f:
+    json.dump(record, f, indent=2)
+
+
 def main():
   """Example usage of the DQBF solver."""
   import argparse
@@ -975,8 +1743,24 @@ Example:
   parser_args.add_argument(
     'filename',
     type=str,
+    nargs='?',
+    default=None,
     help='Path to the DQCIR file to solve'
   )
+
+  parser_args.add_argument(
+    '--batch',
+    type=str,
+    default=None,
+    metavar='LIST',
+    help='Solve every DQCIR file listed in LIST (one per line) in one warm process'
+  )
+
+  parser_args.add_argument(
+    '--server',
+    action='store_true',
+    help='Read filenames as jobs from stdin and answer on stdout until EOF'
+  )
   
   parser_args.add_argument(
     '--info',
@@ -989,13 +1773,138 @@ Example:
     action='store_true',
     help='Detect equivalent existential variables (do not solve)'
   )
+
+  parser_args.add_argument(
+    '--detect-equiv-workers',
+    type=int,
+    default=0,
+    metavar='W',
+    help='Shard equivalence confirmation SAT calls across W worker processes (default: 0 = sequential)'
+  )
   
+  parser_args.add_argument(
+    '--cache',
+    action='store_true',
+    help='Reuse (or write) a binary .dqc snapshot of the parsed formula next to the input'
+  )
+
+  parser_args.add_argument(
+    '--batch-size',
+    type=int,
+    default=1,
+    metavar='K',
+    help='Extract up to K diverse counterexamples per CEGAR iteration (default: 1)'
+  )
+
+  parser_args.add_argument(
+    '--portfolio',
+    type=int,
+    default=0,
+    metavar='N',
+    help='Race counterexample queries across N SAT worker processes (default: 0 = off)'
+  )
+
+  parser_args.add_argument(
+    '--definability',
+    action='store_true',
+    help='Eliminate functionally defined existentials before solving'
+  )
+
+  parser_args.add_argument(
+    '--no-refine-deps',
+    action='store_true',
+    help='Disable standard dependency scheme refinement of dependency sets'
+  )
+
+  parser_args.add_argument(
+    '--pipeline',
+    action='store_true',
+    help='Overlap expansion solving with speculative counterexample search'
+  )
+
+  parser_args.add_argument(
+    '--certificate',
+    type=str,
+    default=None,
+    metavar='FILE',
+    help='Write an AIGER (aag) Skolem-function certificate when satisfiable'
+  )
+
+  parser_args.add_argument(
+    '--compact-interval',
+    type=int,
+    default=0,
+    metavar='C',
+    help='Rebuild the decision lists after C added clauses (default: 0 = off)'
+  )
+
+  parser_args.add_argument(
+    '--polarity-window',
+    type=int,
+    default=0,
+    metavar='W',
+    help='Set defaults by majority over the last W counterexamples per '
+         'existential, with hysteresis (default: 0 = flip on every counterexample)'
+  )
+
+  parser_args.add_argument(
+    '--polarity-hysteresis',
+    type=int,
+    default=4,
+    metavar='H',
+    help='Majority margin required before a default flip with --polarity-window (default: 4)'
+  )
+
+  parser_args.add_argument(
+    '--warm-defaults',
+    action='store_true',
+    help='Pick initial default values by random simulation of the circuit'
+  )
+
+  parser_args.add_argument(
+    '--checkpoint',
+    type=str,
+    default=None,
+    metavar='FILE',
+    help='Periodically save the refinement state to FILE during solving'
+  )
+
+  parser_args.add_argument(
+    '--checkpoint-interval',
+    type=int,
+    default=50,
+    metavar='N',
+    help='Save a checkpoint every N CEGAR iterations (default: 50)'
+  )
+
+  parser_args.add_argument(
+    '--resume',
+    type=str,
+    default=None,
+    metavar='FILE',
+    help='Resume solving from a checkpoint file written by --checkpoint'
+  )
+
+  parser_args.add_argument(
+    '--profile',
+    action='store_true',
+    help='Collect per-phase timings and print a breakdown at exit (and on SIGUSR1)'
+  )
+
+  parser_args.add_argument(
+    '--stats-json',
+    type=str,
+    default=None,
+    metavar='FILE',
+    help='Write the solve result and solver statistics as JSON to FILE'
+  )
+
   parser_args.add_argument(
     '-v', '--verbose',
     action='store_true',
     help='Enable verbose (debug) logging'
   )
-  
+
   args = parser_args.parse_args()
   
   # Setup logging
@@ -1005,32 +1914,84 @@ Example:
     format='%(levelname)s: %(message)s'
   )
   
+  # Batch and server modes amortize interpreter startup and parsed-circuit
+  # state over many jobs; the single-file options below do not apply there
+  if args.batch or args.server:
+    import batch_server
+    server = batch_server.FormulaServer(refine_deps=not args.no_refine_deps)
+    if args.batch:
+      sys.exit(batch_server.run_batch(server, args.batch))
+    batch_server.serve(server, sys.stdin, sys.stdout)
+    sys.exit(0)
+
+  if args.filename is None:
+    parser_args.error('a filename is required unless --batch or --server is given')
+
   # Check if file exists
   if not os.path.isfile(args.filename):
     logging.error(f"File '{args.filename}' does not exist.")
     sys.exit(1)
+
+  # Per-phase profiling (no-op when --profile is not given)
+  profiler = PhaseProfiler(enabled=args.profile)
   
   # Parse the DQCIR file
   logging.info(f"Parsing {args.filename}...")
   try:
-    # Create parser with a fresh counter (starts at 0)
-    parser = DQCIRParser(counter=Counter(0))
-    
-    # Parse the file
-    parser.parse_file(args.filename)
-    logging.debug(f"Parsed {len(parser.name_to_id)} variables and gates")
-    
-    # Generate CNF
-    parser.tseitin_transform()
-    logging.debug(f"Tseitin transformation complete: {len(parser.cnf)} clauses")
-    
-    # Get output gate ID
+    parser = None
+
+    # Try the binary formula cache first
+    if args.cache:
+      import formula_cache
+      parser = formula_cache.load_cache(args.filename)
+      if parser is not None:
+        logging.info(f"Loaded cached formula from {formula_cache.cache_path(args.filename)}")
+
+    if parser is None:
+      # Create parser with a fresh counter (starts at 0)
+      parser = DQCIRParser(counter=Counter(0))
+
+      # Parse the file
+      with profiler.phase('parse'):
+        parser.parse_file(args.filename)
+      logging.debug(f"Parsed {len(parser.name_to_id)} variables and gates")
+
+      # Structurally reduce the circuit (cone of influence, constant propagation)
+      with profiler.phase('reduce_circuit'):
+        reduction_stats = parser.reduce_circuit()
+      logging.debug(f"Circuit reduction removed {reduction_stats['dead_gates']} dead, "
+                    f"{reduction_stats['constant_gates']} constant, "
+                    f"{reduction_stats['alias_gates']} alias gates")
+
+      # Generate CNF
+      with profiler.phase('tseitin_transform'):
+        parser.tseitin_transform()
+      logging.debug(f"Tseitin transformation complete: {len(parser.cnf)} clauses")
+
+      # Write the snapshot for future runs
+      if args.cache:
+        import formula_cache
+        formula_cache.save_cache(parser, args.filename)
+
+    # Get output gate ID (resolved through structural-hashing aliases)
     if not parser.output_gate:
       raise ValueError("No output gate specified in the formula")
-    
-    output_gate_id = parser.name_to_id[parser.output_gate]
+
+    output_gate_id = parser.get_output_gate_id()
     logging.debug(f"Output gate: {parser.output_gate} (ID={output_gate_id})")
-    
+
+    # Substitute functionally defined existentials into the circuit
+    if args.definability:
+      import definability
+      with profiler.phase('definability'):
+        eliminated = definability.eliminate_defined_existentials(parser, output_gate_id)
+      if eliminated:
+        # The circuit changed: rebuild the CNF and re-resolve the output
+        parser.reduce_circuit()
+        parser.tseitin_transform()
+        output_gate_id = parser.get_output_gate_id()
+
+
     # Create counter starting from max ID seen in parsing
     # This allows the solver to create new variables without conflicts
     max_id = max(parser.name_to_id.values()) if parser.name_to_id else 0
@@ -1040,17 +2001,54 @@ Example:
     
     logging.debug(f"Maximum variable ID: {max_id}")
     counter = Counter(max_id)
-    
+
+    # Refine dependency sets with the standard dependency scheme; spurious
+    # front-end dependencies blow up the expansion space exponentially
+    dependencies = parser.dependencies.copy()
+    if not args.no_refine_deps:
+      universal_ids = [parser.name_to_id[v] for v in parser.forall_vars_ordered]
+      deps_by_id = {
+        parser.name_to_id[exist_var]: {parser.name_to_id[dep] for dep in deps}
+        for exist_var, deps in dependencies.items()
+      }
+      with profiler.phase('refine_dependencies'):
+        refined = refine_dependencies(parser.cnf, universal_ids, deps_by_id)
+      dependencies = {
+        exist_var: [dep for dep in deps
+                    if parser.name_to_id[dep] in refined[parser.name_to_id[exist_var]]]
+        for exist_var, deps in dependencies.items()
+      }
+
     # Create solver with parsed data and counter
     solver = DQBFSolver(
       name_to_id=parser.name_to_id.copy(),
       id_to_name=parser.id_to_name.copy(),
-      dependencies=parser.dependencies.copy(),
+      dependencies=dependencies,
       matrix=parser.cnf.copy(),
       universal_vars=parser.forall_vars_ordered.copy(),
       output_gate_id=output_gate_id,
-      counter=counter
+      counter=counter,
+      batch_size=args.batch_size,
+      portfolio_size=args.portfolio,
+      pipeline=args.pipeline,
+      compact_interval=args.compact_interval,
+      profiler=profiler,
+      checkpoint_path=args.checkpoint,
+      checkpoint_interval=args.checkpoint_interval,
+      polarity_window=args.polarity_window,
+      polarity_hysteresis=args.polarity_hysteresis
     )
+
+    if args.warm_defaults:
+      solver.warm_start_defaults(parser.evaluate)
+
+    # Live profile dumps for long runs: kill -USR1 <pid>
+    if args.profile:
+      profiler.install_signal_handler(solver.get_statistics)
+
+    # Resume a long run from its last checkpoint
+    if args.resume:
+      solver.start_iteration = checkpoint.restore_checkpoint(solver, args.resume)
     
     # Get statistics
     stats = solver.get_statistics()
@@ -1073,14 +2071,23 @@ Example:
   
   # Detect equivalent existentials if requested
   if args.detect_equiv:
-    solver.detect_equivalent_existentials()
+    solver.detect_equivalent_existentials(evaluator=parser.evaluate, workers=args.detect_equiv_workers)
     sys.exit(0)
   
   # Try to solve
   logging.info("Solving...")
   try:
-    result = solver.solve()
+    import time
+    solve_start = time.time()
+    with profiler.phase('solve'):
+      result = solver.solve()
+    if args.stats_json:
+      _write_stats_json(args.stats_json, args.filename, result,
+                        time.time() - solve_start, solver)
     if result:
+      if args.certificate:
+        import certificate
+        certificate.write_certificate(solver, args.certificate)
       print(f"Result: SATISFIABLE")
       sys.exit(10)
     else:
@@ -1099,6 +2106,10 @@ Example:
       import traceback
       traceback.print_exc()
     sys.exit(1)
+  finally:
+    if args.profile:
+      logging.info("\n" + profiler.report(solver.get_statistics()))
+    solver.close()
 
 
 if __name__ == "__main__":
@@ -10,20 +10,53 @@ This parser handles the DQCIR format where:
 - The output gate is specified via output(...)
 """
 
+import os
+import time
+
+from clause_store import ClauseStore
 from counter import Counter
 
 
 class DQCIRParser:
   """Parser for DQBF in DQCIR format."""
-  
-  def __init__(self, counter=None):
+
+  # File size (bytes) above which parse_file switches to the streaming scanner
+  STREAMING_THRESHOLD = 64 * 1024 * 1024
+
+  def __init__(self, counter=None, encoding='tseitin', output_polarity='both', streaming=None):
     """Initialize the DQCIR parser.
-    
+
     Args:
       counter: Optional Counter object to use for ID generation.
           If None, a new Counter starting at 0 is created.
+      encoding: CNF translation mode. 'tseitin' (default) emits full
+          biconditional clauses for every gate; 'pg' (Plaisted-Greenbaum)
+          emits only the implications required by each gate's observed
+          polarity, roughly halving the clause count for single-polarity
+          AND/OR cones.
+      output_polarity: Polarity seed for the 'pg' polarity analysis:
+          'positive', 'negative', or 'both'. Use 'both' (default) when the
+          output gate is constrained in both phases, as the CEGAR solver
+          does with its negated/unnegated output assumptions; in that case
+          'pg' degenerates to the full encoding for gates reachable in both
+          polarities but still saves clauses in single-polarity cones.
+      streaming: Force (True) or disable (False) the streaming chunked
+          scanner in parse_file. If None (default), streaming is used for
+          files larger than STREAMING_THRESHOLD.
     """
     self.counter = counter if counter is not None else Counter(0)
+
+    if encoding not in ('tseitin', 'pg'):
+      raise ValueError(f"Unknown encoding mode: {encoding}")
+    if output_polarity not in ('positive', 'negative', 'both'):
+      raise ValueError(f"Unknown output polarity: {output_polarity}")
+    self.encoding = encoding
+    self.output_polarity = output_polarity
+    self.streaming = streaming
+
+    # Parse throughput figures from the last parse_file call
+    self.parse_bytes = 0
+    self.parse_seconds = 0.0
     
     # Mapping from variable/gate names to integer IDs
     self.name_to_id = {}
@@ -44,6 +77,12 @@ class DQCIRParser:
     # Dictionary mapping gate IDs to their type and inputs
     # Key: gate ID, Value: dict with 'type' (and/or/xor) and 'inputs' (list of IDs)
     self.gates = {}
+
+    # Structural-hashing aliases: duplicate gate ID -> representative gate ID
+    self.gate_aliases = {}
+
+    # Number of gates merged by structural hashing during the last parse
+    self.merged_gate_count = 0
     
     # Output gate name
     self.output_gate = None
@@ -51,11 +90,14 @@ class DQCIRParser:
     # List of all forall variables in order of introduction
     self.forall_vars_ordered = []
     
-    # CNF clauses generated by Tseitin transformation
-    self.cnf = []
-    
+    # CNF clauses generated by Tseitin transformation, stored flat
+    self.cnf = ClauseStore()
+
     # Auxiliary variables created during Tseitin transformation
     self.aux_vars = set()
+
+    # Statistics from the last reduce_circuit call (None if not run)
+    self.reduction_stats = None
   
   def _get_or_create_id(self, name):
     """Get existing ID for a name, or create a new one."""
@@ -82,20 +124,193 @@ class DQCIRParser:
   
   def parse_file(self, filename):
     """Parse a DQCIR file.
-    
+
+    Large files are scanned with the streaming chunked reader (see
+    _parse_stream); small files use plain line iteration. The choice can be
+    forced via the streaming constructor argument.
+
     Args:
       filename: Path to the DQCIR file
     """
-    with open(filename, 'r') as f:
-      for line in f:
-        line = line.strip()
-        
-        # Skip empty lines and comments
-        if not line or line.startswith('#'):
-          continue
-        
-        self._parse_line(line)
-  
+    start_time = time.perf_counter()
+    file_size = os.path.getsize(filename)
+
+    use_streaming = self.streaming
+    if use_streaming is None:
+      use_streaming = file_size >= self.STREAMING_THRESHOLD
+
+    if use_streaming:
+      self._parse_stream(filename)
+    else:
+      with open(filename, 'r') as f:
+        for line in f:
+          line = line.strip()
+
+          # Skip empty lines and comments
+          if not line or line.startswith('#'):
+            continue
+
+          self._parse_line(line)
+
+    self.parse_bytes = file_size
+    self.parse_seconds = time.perf_counter() - start_time
+
+    # Merge structurally identical gates
+    self.merged_gate_count = self.structural_hash_gates()
+
+  def _parse_stream(self, filename, chunk_size=4 * 1024 * 1024):
+    """Parse a DQCIR file with chunked reads and a single-pass line scanner.
+
+    Instead of iterating the file line by line, multi-megabyte chunks are read
+    and split on newlines in one pass, carrying any partial trailing line over
+    to the next chunk. Peak memory stays bounded by the chunk size regardless
+    of file size, and per-line overhead is avoided for blank and comment lines
+    by checking the first character before stripping.
+
+    Args:
+      filename: Path to the DQCIR file
+      chunk_size: Number of characters to read per chunk
+    """
+    with open(filename, 'r', buffering=chunk_size) as f:
+      tail = ''
+      while True:
+        chunk = f.read(chunk_size)
+        if not chunk:
+          break
+        if tail:
+          chunk = tail + chunk
+        lines = chunk.split('\n')
+        tail = lines.pop()
+        for line in lines:
+          # Cheap pre-filter before the full strip
+          if not line or line[0] == '#' or line.isspace():
+            continue
+          line = line.strip()
+          if line and not line.startswith('#'):
+            self._parse_line(line)
+      if tail:
+        line = tail.strip()
+        if line and not line.startswith('#'):
+          self._parse_line(line)
+
+  def _resolve_gate_alias(self, gate_id):
+    """Follow structural-hashing aliases to the representative gate ID."""
+    while gate_id in self.gate_aliases:
+      gate_id = self.gate_aliases[gate_id]
+    return gate_id
+
+  def get_output_gate_id(self):
+    """Get the ID of the output gate, resolved through structural-hashing aliases.
+
+    Returns:
+      int: The representative ID of the output gate, or None if no output
+         gate was declared
+    """
+    if self.output_gate is None:
+      return None
+    return self._resolve_gate_alias(self.name_to_id[self.output_gate])
+
+  def structural_hash_gates(self):
+    """Merge structurally identical gates (same type, same input literal multiset).
+
+    Gates are canonicalized by their type and sorted, alias-resolved input
+    literals (AND/OR/XOR are all commutative). Duplicate gates are mapped to
+    one representative ID via gate_aliases and removed; downstream references
+    are rewritten. Merging can expose further duplicates (e.g. when
+    structurally equal subtrees collapse), so hashing is iterated to a
+    fixpoint.
+
+    Returns:
+      int: Number of gates merged away
+    """
+    merged_total = 0
+    changed = True
+    while changed:
+      changed = False
+      table = {}
+      for gate_id in sorted(self.gates):
+        gate_info = self.gates[gate_id]
+        resolved = [(self._resolve_gate_alias(inp_id), is_negated)
+                    for inp_id, is_negated in gate_info['inputs']]
+        gate_info['inputs'] = resolved
+        key = (gate_info['type'], tuple(sorted(resolved)))
+        representative = table.get(key)
+        if representative is None:
+          table[key] = gate_id
+        else:
+          self.gate_aliases[gate_id] = representative
+          del self.gates[gate_id]
+          merged_total += 1
+          changed = True
+
+    # Final rewrite so that no remaining gate references an alias
+    for gate_info in self.gates.values():
+      gate_info['inputs'] = [(self._resolve_gate_alias(inp_id), is_negated)
+                             for inp_id, is_negated in gate_info['inputs']]
+
+    return merged_total
+
+  def evaluate(self, input_values):
+    """Evaluate the circuit under an assignment to its input variables.
+
+    Gates are evaluated with a memoized, iterative depth-first walk from the
+    output gate, so evaluation is linear in the cone of the output and safe
+    for deep circuits (no recursion). Input variables missing from
+    input_values default to False.
+
+    Args:
+      input_values: Dictionary mapping input variable IDs to booleans
+
+    Returns:
+      bool: The value of the output gate under the assignment
+
+    Raises:
+      ValueError: If no output gate was declared
+    """
+    output_gate_id = self.get_output_gate_id()
+    if output_gate_id is None:
+      raise ValueError("No output gate specified in the formula")
+
+    values = {}
+    stack = [output_gate_id]
+    while stack:
+      gate_id = self._resolve_gate_alias(stack[-1])
+      if gate_id in values or gate_id in input_values:
+        stack.pop()
+        continue
+      gate_info = self.gates.get(gate_id)
+      if gate_info is None:
+        # Not a gate: an undeclared input, defaulting to False
+        values[gate_id] = False
+        stack.pop()
+        continue
+
+      pending = [inp_id for inp_id, _ in gate_info['inputs']
+                 if self._resolve_gate_alias(inp_id) not in values
+                 and self._resolve_gate_alias(inp_id) not in input_values]
+      if pending:
+        stack.extend(pending)
+        continue
+
+      inputs = []
+      for inp_id, is_negated in gate_info['inputs']:
+        inp_id = self._resolve_gate_alias(inp_id)
+        value = input_values[inp_id] if inp_id in input_values else values[inp_id]
+        inputs.append(not value if is_negated else value)
+
+      gate_type = gate_info['type']
+      if gate_type == 'and':
+        values[gate_id] = all(inputs)
+      elif gate_type == 'or':
+        values[gate_id] = any(inputs)
+      elif gate_type == 'xor':
+        values[gate_id] = sum(inputs) % 2 == 1
+      else:
+        raise ValueError(f"Unknown gate type: {gate_type}")
+      stack.pop()
+
+    return values[output_gate_id]
+
   def _parse_line(self, line):
     """Parse a single line of DQCIR format."""
     
@@ -150,10 +365,12 @@ class DQCIRParser:
         self.exists_vars.add(var)
         exists_vars.append(var)
     
-    # Each existential variable in exists block depends on all forall vars seen so far
+    # Each existential variable in exists block depends on all forall vars
+    # seen so far; one shared snapshot per block instead of a copy per variable
+    block_deps = list(self.forall_vars_ordered)
     for var in exists_vars:
       if var not in self.dependencies:
-        self.dependencies[var] = list(self.forall_vars_ordered)
+        self.dependencies[var] = block_deps
   
   def _parse_depend(self, line):
     """Parse a depend(var, dep1, dep2, ...) line."""
@@ -291,78 +508,285 @@ class DQCIRParser:
     
     return aux_id
   
+  def reduce_circuit(self):
+    """Structurally reduce the circuit before CNF generation.
+
+    Three reductions are applied:
+    1. Constant propagation: gates that evaluate to a constant (e.g. an AND
+       with a constant-false input, or a gate with no inputs) are removed and
+       the constant is substituted into their consumers.
+    2. Alias elimination: single-input AND/OR/XOR gates are replaced by their
+       (possibly negated) input literal in all consumers.
+    3. Cone of influence: gates not reachable from the output gate are dropped
+       entirely, so they produce no Tseitin variables or clauses.
+
+    The output gate itself is never replaced by a constant or alias; its
+    (simplified) definition is kept so that the gate variable remains
+    constrained for the solver.
+
+    Returns:
+      dict: Counts of removed gates per category
+         ('dead_gates', 'constant_gates', 'alias_gates')
+    """
+    stats = {'dead_gates': 0, 'constant_gates': 0, 'alias_gates': 0}
+
+    output_id = self.name_to_id.get(self.output_gate) if self.output_gate else None
+
+    # gate_id -> constant value, and gate_id -> (replacement_id, negated)
+    constants = {}
+    aliases = {}
+
+    def resolve(inp_id, negated):
+      """Follow alias/constant chains to a literal or a constant."""
+      while True:
+        if inp_id in constants:
+          return ('const', constants[inp_id] != negated)
+        alias = aliases.get(inp_id)
+        if alias is None:
+          return (inp_id, negated)
+        inp_id = alias[0]
+        negated = negated != alias[1]
+
+    # Iterate to a fixpoint: simplifying one gate can expose constants or
+    # aliases in its consumers regardless of definition order in the file
+    changed = True
+    while changed:
+      changed = False
+      for gate_id, gate_info in list(self.gates.items()):
+        gate_type = gate_info['type']
+
+        # Resolve inputs and fold constants into the gate semantics
+        new_inputs = []
+        const_value = None
+        parity_flip = False
+        for inp_id, is_negated in gate_info['inputs']:
+          resolved = resolve(inp_id, is_negated)
+          if resolved[0] == 'const':
+            value = resolved[1]
+            if gate_type == 'and':
+              if not value:
+                const_value = False
+                break
+              # Constant-true inputs of an AND are dropped
+            elif gate_type == 'or':
+              if value:
+                const_value = True
+                break
+              # Constant-false inputs of an OR are dropped
+            else:
+              # Constant-true inputs of an XOR flip the parity
+              if value:
+                parity_flip = not parity_flip
+          else:
+            new_inputs.append(resolved)
+
+        # Fold an XOR parity flip into a negation of the first input
+        if parity_flip and new_inputs:
+          first_id, first_neg = new_inputs[0]
+          new_inputs[0] = (first_id, not first_neg)
+          parity_flip = False
+
+        # Determine whether the gate reduces to a constant
+        if const_value is None and not new_inputs:
+          if gate_type == 'and':
+            const_value = True
+          elif gate_type == 'or':
+            const_value = False
+          else:
+            const_value = parity_flip
+
+        if const_value is not None:
+          if gate_id == output_id:
+            # Keep the output gate; an empty AND/OR natively encodes the constant
+            reduced = {'type': 'and' if const_value else 'or', 'inputs': []}
+            if gate_info != reduced:
+              self.gates[gate_id] = reduced
+              changed = True
+          else:
+            constants[gate_id] = const_value
+            del self.gates[gate_id]
+            stats['constant_gates'] += 1
+            changed = True
+          continue
+
+        if len(new_inputs) == 1 and gate_id != output_id:
+          # Single-input gates of any type are aliases of their input literal
+          aliases[gate_id] = new_inputs[0]
+          del self.gates[gate_id]
+          stats['alias_gates'] += 1
+          changed = True
+          continue
+
+        if new_inputs != gate_info['inputs']:
+          gate_info['inputs'] = new_inputs
+          changed = True
+
+    # Restrict to the cone of influence of the output gate
+    reachable = set()
+    worklist = [output_id] if output_id in self.gates else []
+    while worklist:
+      gate_id = worklist.pop()
+      if gate_id in reachable:
+        continue
+      reachable.add(gate_id)
+      for inp_id, _ in self.gates[gate_id]['inputs']:
+        if inp_id in self.gates:
+          worklist.append(inp_id)
+
+    dead = [gate_id for gate_id in self.gates if gate_id not in reachable]
+    for gate_id in dead:
+      del self.gates[gate_id]
+    stats['dead_gates'] = len(dead)
+
+    self.reduction_stats = stats
+    return stats
+
+  def _compute_gate_polarities(self):
+    """Compute the polarities under which each gate is observed.
+
+    Starting from the output gate with the configured seed polarity, polarities
+    are propagated through AND/OR gates (flipped by input negation) and in both
+    phases through XOR gates. Gates not reachable from the output keep both
+    polarities so that they are still translated with the full encoding.
+
+    Returns:
+      dict: Mapping from gate ID to a set of booleans (True for positive
+         occurrences, False for negative occurrences)
+    """
+    polarities = {}
+
+    if self.output_polarity == 'both':
+      seed = (True, False)
+    elif self.output_polarity == 'positive':
+      seed = (True,)
+    else:
+      seed = (False,)
+
+    worklist = []
+    if self.output_gate is not None:
+      output_id = self.name_to_id.get(self.output_gate)
+      if output_id in self.gates:
+        for polarity in seed:
+          worklist.append((output_id, polarity))
+
+    while worklist:
+      gate_id, polarity = worklist.pop()
+      seen = polarities.setdefault(gate_id, set())
+      if polarity in seen:
+        continue
+      seen.add(polarity)
+
+      gate_info = self.gates[gate_id]
+      for inp_id, is_negated in gate_info['inputs']:
+        if inp_id not in self.gates:
+          continue
+        if gate_info['type'] == 'xor':
+          # XOR observes its inputs in both phases
+          worklist.append((inp_id, True))
+          worklist.append((inp_id, False))
+        else:
+          worklist.append((inp_id, polarity != is_negated))
+
+    # Gates not reachable from the output are translated with both polarities
+    for gate_id in self.gates:
+      if gate_id not in polarities:
+        polarities[gate_id] = {True, False}
+
+    return polarities
+
   def tseitin_transform(self):
-    """Apply Tseitin transformation to generate CNF equivalent to the circuit.
-    
+    """Apply the CNF translation to the circuit.
+
+    In 'tseitin' mode every gate is translated with full biconditional
+    clauses. In 'pg' (Plaisted-Greenbaum) mode AND/OR gates only emit the
+    implications required by the polarities under which they are observed
+    from the output gate; XOR gates always use the full encoding.
+
     Returns:
-      list: CNF formula as a list of clauses, where each clause is a list of integers.
-         Positive integers represent positive literals, negative integers represent
-         negative literals.
+      ClauseStore: CNF formula in flat int32 storage; iterating it or indexing
+         into it yields clauses as lists of integers, where positive integers
+         represent positive literals and negative integers negative literals.
     """
-    self.cnf = []
-    
+    self.cnf = ClauseStore()
+
+    if self.encoding == 'pg':
+      polarities = self._compute_gate_polarities()
+    else:
+      polarities = None
+
     # Process each gate and generate Tseitin clauses
     for gate_id, gate_info in self.gates.items():
       gate_type = gate_info['type']
       inputs = gate_info['inputs']
-      
+      gate_polarities = polarities[gate_id] if polarities is not None else {True, False}
+
       if gate_type == 'and':
-        self._tseitin_and(gate_id, inputs)
+        self._tseitin_and(gate_id, inputs, gate_polarities)
       elif gate_type == 'or':
-        self._tseitin_or(gate_id, inputs)
+        self._tseitin_or(gate_id, inputs, gate_polarities)
       elif gate_type == 'xor':
         self._tseitin_xor(gate_id, inputs)
-    
+
     # Note: We do NOT add a unit clause for the output gate
     # This allows the solver to explore both satisfying and unsatisfying assignments
-    
+
     return self.cnf
   
-  def _tseitin_and(self, gate_id, inputs):
+  def _tseitin_and(self, gate_id, inputs, polarities={True, False}):
     """Generate Tseitin clauses for AND gate: gate_id <=> (input1 AND input2 AND ...)
-    
+
     Clauses:
     1. gate_id => input1 AND input2 AND ...  (for each input: -gate_id OR input)
+       Needed when the gate is observed positively.
     2. input1 AND input2 AND ... => gate_id  (gate_id OR -input1 OR -input2 OR ...)
-    
+       Needed when the gate is observed negatively.
+
     Args:
       gate_id: ID of the gate
       inputs: List of (input_id, is_negated) tuples
+      polarities: Set of polarities under which the gate is observed
     """
-    # gate_id => each input
-    for inp_id, is_negated in inputs:
-      literal = -inp_id if is_negated else inp_id
-      self.cnf.append([-gate_id, literal])
-    
-    # all inputs => gate_id
-    clause = [gate_id]
-    for inp_id, is_negated in inputs:
-      literal = inp_id if is_negated else -inp_id
-      clause.append(literal)
-    self.cnf.append(clause)
-  
-  def _tseitin_or(self, gate_id, inputs):
+    if True in polarities:
+      # gate_id => each input
+      for inp_id, is_negated in inputs:
+        literal = -inp_id if is_negated else inp_id
+        self.cnf.append([-gate_id, literal])
+
+    if False in polarities:
+      # all inputs => gate_id
+      clause = [gate_id]
+      for inp_id, is_negated in inputs:
+        literal = inp_id if is_negated else -inp_id
+        clause.append(literal)
+      self.cnf.append(clause)
+
+  def _tseitin_or(self, gate_id, inputs, polarities={True, False}):
     """Generate Tseitin clauses for OR gate: gate_id <=> (input1 OR input2 OR ...)
-    
+
     Clauses:
     1. input1 OR input2 OR ... => gate_id  (for each input: input OR -gate_id)
+       Needed when the gate is observed negatively.
     2. gate_id => input1 OR input2 OR ...  (-gate_id OR input1 OR input2 OR ...)
-    
+       Needed when the gate is observed positively.
+
     Args:
       gate_id: ID of the gate
       inputs: List of (input_id, is_negated) tuples
+      polarities: Set of polarities under which the gate is observed
     """
-    # each input => gate_id
-    for inp_id, is_negated in inputs:
-      literal = -inp_id if is_negated else inp_id
-      self.cnf.append([-literal, gate_id])
-    
-    # gate_id => at least one input
-    clause = [-gate_id]
-    for inp_id, is_negated in inputs:
-      literal = -inp_id if is_negated else inp_id
-      clause.append(literal)
-    self.cnf.append(clause)
+    if False in polarities:
+      # each input => gate_id
+      for inp_id, is_negated in inputs:
+        literal = -inp_id if is_negated else inp_id
+        self.cnf.append([-literal, gate_id])
+
+    if True in polarities:
+      # gate_id => at least one input
+      clause = [-gate_id]
+      for inp_id, is_negated in inputs:
+        literal = -inp_id if is_negated else inp_id
+        clause.append(literal)
+      self.cnf.append(clause)
   
   def _tseitin_xor(self, gate_id, inputs):
     """Generate Tseitin clauses for XOR gate: gate_id <=> (input1 XOR input2 XOR ...)
@@ -472,12 +896,25 @@ class DQCIRParser:
     print("DQCIR Parser Summary")
     print("=" * 60)
     
+    if self.parse_seconds > 0:
+      throughput = self.parse_bytes / self.parse_seconds / (1024 * 1024)
+      print(f"\nParsed {self.parse_bytes} bytes in {self.parse_seconds:.3f} s "
+            f"({throughput:.1f} MiB/s)")
+
     print(f"\nTotal variables/gates: {self.counter.n}")
     print(f"Universal variables: {len(self.forall_vars)}")
     print(f"Existential variables: {len(self.exists_vars)}")
     print(f"Gates: {len(self.gates)}")
     print(f"Output gate: {self.output_gate}")
     
+    if self.merged_gate_count:
+      print(f"Merged by structural hashing: {self.merged_gate_count} gates")
+
+    if self.reduction_stats is not None:
+      print(f"Removed by reduction: {self.reduction_stats['dead_gates']} dead, "
+            f"{self.reduction_stats['constant_gates']} constant, "
+            f"{self.reduction_stats['alias_gates']} alias gates")
+
     if self.aux_vars:
       print(f"Auxiliary variables (Tseitin): {len(self.aux_vars)}")
     
@@ -556,7 +993,27 @@ Example:
     action='store_true',
     help='Display sample CNF clauses in summary (implies --cnf)'
   )
-  
+
+  parser_args.add_argument(
+    '--reduce',
+    action='store_true',
+    help='Apply cone-of-influence and constant-propagation reduction before CNF generation'
+  )
+
+  parser_args.add_argument(
+    '--encoding',
+    choices=['tseitin', 'pg'],
+    default='tseitin',
+    help='CNF translation mode: full Tseitin or polarity-aware Plaisted-Greenbaum'
+  )
+
+  parser_args.add_argument(
+    '--output-polarity',
+    choices=['positive', 'negative', 'both'],
+    default='both',
+    help='Polarity seed at the output gate for the pg encoding (default: both)'
+  )
+
   args = parser_args.parse_args()
   
   # Check if file exists
@@ -570,10 +1027,16 @@ Example:
     sys.exit(1)
   
   # Parse the file
-  parser = DQCIRParser()
+  parser = DQCIRParser(encoding=args.encoding, output_polarity=args.output_polarity)
   try:
     parser.parse_file(args.filename)
-    
+
+    # Reduce the circuit if requested
+    if args.reduce:
+      stats = parser.reduce_circuit()
+      print(f"Reduction removed {stats['dead_gates']} dead, {stats['constant_gates']} constant, "
+            f"{stats['alias_gates']} alias gates.")
+
     # Generate CNF if requested
     if args.cnf or args.show_cnf:
       print("Generating CNF using Tseitin transformation...")
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Parallel Pairwise Equivalence Checking
+
+Confirms candidate pairs of equivalent existential variables with SAT calls
+sharded across worker processes. Each worker owns one solver bootstrapped
+with the CNF matrix and a private variable counter for the selector
+variables guarding the per-pair difference clauses, so checks never
+interfere; results are returned to the caller for merging into its
+union-find structure.
+"""
+
+import multiprocessing
+from typing import List, Tuple
+
+from counter import Counter
+
+# Per-worker state, set up once by _init_worker
+_worker_solver = None
+_worker_counter = None
+_worker_output_gate_id = None
+
+
+def _init_worker(matrix: List[List[int]], counter_start: int, output_gate_id: int) -> None:
+  """Initialize one worker process: private solver and selector counter."""
+  global _worker_solver, _worker_counter, _worker_output_gate_id
+  from pysat.solvers import Cadical195 as SAT
+
+  _worker_solver = SAT(bootstrap_with=matrix)
+  _worker_counter = Counter(counter_start)
+  _worker_output_gate_id = output_gate_id
+
+
+def _check_pair(task: Tuple[int, int, List[int], List[int]]) -> Tuple[int, int, bool]:
+  """Check one candidate pair on this worker's solver.
+
+  Args:
+    task: (var1_id, var2_id, deps1, deps2) with dependency lists in order
+
+  Returns:
+    (var1_id, var2_id, equivalent) where equivalent is True when the pair
+    cannot be forced to different values under equal dependency assignments
+  """
+  var1_id, var2_id, deps1, deps2 = task
+
+  selector = _worker_counter.increase()
+  for dep_var1, dep_var2 in zip(deps1, deps2):
+    _worker_solver.add_clause([-selector, dep_var1, -dep_var2])
+    _worker_solver.add_clause([-selector, -dep_var1, dep_var2])
+
+  _worker_solver.add_clause([-selector, var1_id, var2_id])
+  _worker_solver.add_clause([-selector, -var1_id, -var2_id])
+
+  result = _worker_solver.solve(assumptions=[selector, _worker_output_gate_id])
+  return (var1_id, var2_id, not result)
+
+
+class ParallelPairChecker:
+  """Pool of worker processes confirming equivalence candidate pairs."""
+
+  def __init__(self, matrix: List[List[int]], counter_start: int, output_gate_id: int, workers: int):
+    """Start the worker pool.
+
+    Args:
+      matrix: CNF matrix every worker bootstraps its solver with
+      counter_start: First variable ID workers may use for selectors
+      output_gate_id: Output gate assumed true in every check
+      workers: Number of worker processes
+    """
+    self.workers = max(1, workers)
+    self.pool = multiprocessing.Pool(
+      self.workers,
+      initializer=_init_worker,
+      initargs=(matrix, counter_start, output_gate_id)
+    )
+
+  def check(self, tasks: List[Tuple[int, int, List[int], List[int]]]) -> List[Tuple[int, int, bool]]:
+    """Check a batch of candidate pairs across the pool.
+
+    Args:
+      tasks: (var1_id, var2_id, deps1, deps2) tuples
+
+    Returns:
+      (var1_id, var2_id, equivalent) results in arbitrary order
+    """
+    return self.pool.map(_check_pair, tasks)
+
+  def close(self) -> None:
+    """Shut down the worker pool."""
+    self.pool.close()
+    self.pool.join()
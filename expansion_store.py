@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Dense Expansion Model Store
+
+Holds the expansion solver's current model as a dense array indexed by
+expansion variable ID, so the assumed value of any expansion variable is an
+O(1) lookup instead of a scan over the assignment list. The store also
+maintains the assignment as a flat literal list updated in place (expansion
+variables only accumulate; their signs flip between models), which is handed
+directly to the counterexample solver as the expansion part of the
+assumption vector.
+"""
+
+from typing import List, Optional
+
+# Dense cell values: variable not part of the model, assumed false, assumed true
+VALUE_UNSET = 0
+VALUE_FALSE = 1
+VALUE_TRUE = 2
+
+
+class ExpansionModelStore:
+  """Expansion-variable assignment with O(1) value lookup and in-place updates."""
+
+  def __init__(self, initial_size: int = 0):
+    """Initialize the store.
+
+    Args:
+      initial_size: Initial number of variable IDs the dense array covers;
+                    the array grows geometrically as IDs exceed it
+    """
+    self._values = bytearray(initial_size + 1)
+
+    # Flat literal list handed out as the assumption region
+    self._literals: List[int] = []
+
+    # Mapping from expansion variable ID to index into the literal list
+    self._literal_index = {}
+
+  def _ensure_size(self, var_id: int) -> None:
+    """Grow the dense array to cover var_id."""
+    if var_id >= len(self._values):
+      new_size = max(var_id + 1, 2 * len(self._values))
+      self._values.extend(bytearray(new_size - len(self._values)))
+
+  def set_literal(self, lit: int) -> None:
+    """Record the assumed value of an expansion variable (in place).
+
+    Args:
+      lit: Positive literal for an assumed-true variable, negative for false
+    """
+    var_id = abs(lit)
+    self._ensure_size(var_id)
+    self._values[var_id] = VALUE_TRUE if lit > 0 else VALUE_FALSE
+
+    index = self._literal_index.get(var_id)
+    if index is None:
+      self._literal_index[var_id] = len(self._literals)
+      self._literals.append(lit)
+    else:
+      self._literals[index] = lit
+
+  def value_of(self, var_id: int) -> Optional[bool]:
+    """Return the assumed value of an expansion variable in O(1).
+
+    Args:
+      var_id: The expansion variable's ID
+
+    Returns:
+      True/False for an assumed value, or None if the variable has no value
+      in the current model
+    """
+    if var_id >= len(self._values):
+      return None
+    cell = self._values[var_id]
+    if cell == VALUE_UNSET:
+      return None
+    return cell == VALUE_TRUE
+
+  def literals(self) -> List[int]:
+    """Return the current assignment as a literal list.
+
+    The returned list is the live buffer; callers must not mutate it.
+    """
+    return self._literals
+
+  def __len__(self) -> int:
+    """Return the number of expansion variables with an assumed value."""
+    return len(self._literals)
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Expansion Variable Trie
+
+Prefix-tree index over dependency assignments, one level per dependency
+variable in a fixed order. Looking up the expansion variable for an
+assignment previously required sorting the literal list into a canonical
+tuple and hashing the whole tuple (O(d log d) per call); the trie walks the
+dependency order once per lookup instead, accepts unsorted and partial
+assignments (generalized rule premises leave some dependencies open), and
+supports prefix enumeration so assignments agreeing on a prefix of the
+dependency order can be visited together.
+"""
+
+from typing import Dict, Iterable, Iterator, List, Optional, Tuple
+
+# Child slots per trie node: one per polarity of the level's dependency
+# variable plus one for assignments that leave the variable open
+BRANCH_FALSE = 0
+BRANCH_TRUE = 1
+BRANCH_ABSENT = 2
+
+
+class TrieNode:
+  """One trie level: three child slots and an optional stored variable."""
+
+  __slots__ = ('children', 'value')
+
+  def __init__(self):
+    self.children: List[Optional['TrieNode']] = [None, None, None]
+    self.value: Optional[int] = None
+
+
+class ExpansionTrie:
+  """Trie mapping (partial) dependency assignments to expansion variables."""
+
+  def __init__(self, dep_order: List[int], level_of: Optional[Dict[int, int]] = None):
+    """Initialize a trie for one existential variable.
+
+    Args:
+      dep_order: The variable's dependency variable IDs in a fixed order;
+                 each trie level corresponds to one entry of this list
+      level_of: Optional prebuilt variable-to-level map for dep_order,
+                shared across tries with the same dependency order (see
+                DependencyTable.level_map); built locally when omitted
+    """
+    self.dep_order = dep_order
+    if level_of is None:
+      level_of = {var: i for i, var in enumerate(dep_order)}
+    self.level_of = level_of
+    self.root = TrieNode()
+    self.size = 0
+
+  def __len__(self) -> int:
+    return self.size
+
+  def _branches(self, literals: Iterable[int]) -> List[int]:
+    """Map a literal iterable to one branch index per trie level.
+
+    Args:
+      literals: Unsorted literals over (a subset of) the dependency variables
+
+    Returns:
+      List of branch indices, one per dependency variable in order
+
+    Raises:
+      ValueError: If a literal's variable is not in the dependency order
+    """
+    branches = [BRANCH_ABSENT] * len(self.dep_order)
+    for lit in literals:
+      level = self.level_of.get(abs(lit))
+      if level is None:
+        raise ValueError(f"Literal {lit} is not over a dependency variable")
+      branches[level] = BRANCH_TRUE if lit > 0 else BRANCH_FALSE
+    return branches
+
+  def lookup(self, literals: Iterable[int]) -> Optional[int]:
+    """Find the expansion variable stored for an assignment, if any.
+
+    Args:
+      literals: Unsorted literals over (a subset of) the dependency variables
+
+    Returns:
+      The stored expansion variable ID, or None if the assignment is new
+    """
+    node = self.root
+    for branch in self._branches(literals):
+      node = node.children[branch]
+      if node is None:
+        return None
+    return node.value
+
+  def store(self, literals: Iterable[int], expansion_var_id: int) -> None:
+    """Store an expansion variable for an assignment, creating nodes as needed.
+
+    Args:
+      literals: Unsorted literals over (a subset of) the dependency variables
+      expansion_var_id: The expansion variable ID to store
+    """
+    node = self.root
+    for branch in self._branches(literals):
+      child = node.children[branch]
+      if child is None:
+        child = TrieNode()
+        node.children[branch] = child
+      node = child
+    if node.value is None:
+      self.size += 1
+    node.value = expansion_var_id
+
+  def items_with_prefix(self, prefix_literals: Iterable[int] = ()) -> Iterator[Tuple[Tuple[int, ...], int]]:
+    """Enumerate stored assignments agreeing with a prefix of the dependency order.
+
+    Args:
+      prefix_literals: Literals over the first k dependency variables (in any
+                       order); levels beyond the prefix are enumerated freely
+
+    Yields:
+      (assignment tuple in dependency order, expansion variable ID) pairs
+    """
+    branches = self._branches(prefix_literals)
+    prefix_depth = 0
+    for level, branch in enumerate(branches):
+      if branch != BRANCH_ABSENT:
+        prefix_depth = level + 1
+
+    def walk(node: TrieNode, level: int, assignment: List[int]) -> Iterator[Tuple[Tuple[int, ...], int]]:
+      if level == len(self.dep_order):
+        if node.value is not None:
+          yield (tuple(assignment), node.value)
+        return
+      var = self.dep_order[level]
+      if level < prefix_depth and branches[level] != BRANCH_ABSENT:
+        allowed = [branches[level]]
+      else:
+        allowed = [BRANCH_FALSE, BRANCH_TRUE, BRANCH_ABSENT]
+      for branch in allowed:
+        child = node.children[branch]
+        if child is None:
+          continue
+        if branch == BRANCH_ABSENT:
+          yield from walk(child, level + 1, assignment)
+        else:
+          assignment.append(var if branch == BRANCH_TRUE else -var)
+          yield from walk(child, level + 1, assignment)
+          assignment.pop()
+
+    yield from walk(self.root, 0, [])
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Binary Formula Cache
+
+Serializes a fully parsed and translated DQCIR formula (variable tables,
+dependencies, gates, Tseitin CNF, and counter state) to a compact binary
+snapshot next to the input file, so repeated runs on the same formula skip
+parsing and CNF generation entirely. Snapshots are validated against a
+content hash of the source file and a format version, and are rebuilt
+transparently when either does not match.
+"""
+
+import hashlib
+import logging
+import os
+import pickle
+
+from counter import Counter
+from dqcir_parser import DQCIRParser
+
+# Bump whenever the snapshot layout or the parser state it captures changes
+# (version 2: parser.cnf is a flat ClauseStore instead of a list of lists)
+CACHE_FORMAT_VERSION = 2
+
+# Cache files live next to the input as <input>.dqc
+CACHE_SUFFIX = '.dqc'
+
+
+def cache_path(filename):
+  """Return the cache file path for a DQCIR input file."""
+  return filename + CACHE_SUFFIX
+
+
+def file_hash(filename):
+  """Compute the SHA-256 content hash of a file (streamed)."""
+  digest = hashlib.sha256()
+  with open(filename, 'rb') as f:
+    while True:
+      block = f.read(1024 * 1024)
+      if not block:
+        break
+      digest.update(block)
+  return digest.hexdigest()
+
+
+def save_cache(parser, filename):
+  """Write a binary snapshot of a parsed formula next to its input file.
+
+  The snapshot captures the parser state after parse_file, any circuit
+  reduction, and tseitin_transform, so a reload can construct a DQBFSolver
+  without re-running any of those stages.
+
+  Args:
+    parser: The DQCIRParser whose state should be serialized
+    filename: Path to the DQCIR source file (used for hashing and placement)
+  """
+  snapshot = {
+    'version': CACHE_FORMAT_VERSION,
+    'source_hash': file_hash(filename),
+    'name_to_id': parser.name_to_id,
+    'id_to_name': parser.id_to_name,
+    'forall_vars': parser.forall_vars,
+    'exists_vars': parser.exists_vars,
+    'dependencies': parser.dependencies,
+    'gates': parser.gates,
+    'gate_aliases': parser.gate_aliases,
+    'output_gate': parser.output_gate,
+    'forall_vars_ordered': parser.forall_vars_ordered,
+    'cnf': parser.cnf,
+    'aux_vars': parser.aux_vars,
+    'counter': parser.counter.n,
+    'merged_gate_count': parser.merged_gate_count,
+    'reduction_stats': parser.reduction_stats,
+  }
+
+  path = cache_path(filename)
+  temp_path = path + '.tmp'
+  with open(temp_path, 'wb') as f:
+    pickle.dump(snapshot, f, protocol=pickle.HIGHEST_PROTOCOL)
+  # Atomic replace so a crash never leaves a truncated cache behind
+  os.replace(temp_path, path)
+  logging.debug(f"Wrote formula cache to {path}")
+
+
+def load_cache(filename):
+  """Load a binary snapshot for a DQCIR input file, if valid.
+
+  Args:
+    filename: Path to the DQCIR source file
+
+  Returns:
+    A DQCIRParser reconstructed from the snapshot, or None if no cache
+    exists, the cache has a different format version, or the source file
+    changed since the cache was written
+  """
+  path = cache_path(filename)
+  if not os.path.isfile(path):
+    return None
+
+  try:
+    with open(path, 'rb') as f:
+      snapshot = pickle.load(f)
+  except (OSError, pickle.UnpicklingError, EOFError) as e:
+    logging.debug(f"Ignoring unreadable formula cache {path}: {e}")
+    return None
+
+  if snapshot.get('version') != CACHE_FORMAT_VERSION:
+    logging.debug(f"Ignoring formula cache {path} with stale format version")
+    return None
+
+  if snapshot.get('source_hash') != file_hash(filename):
+    logging.debug(f"Ignoring formula cache {path}: source file changed")
+    return None
+
+  parser = DQCIRParser(counter=Counter(snapshot['counter']))
+  parser.name_to_id = snapshot['name_to_id']
+  parser.id_to_name = snapshot['id_to_name']
+  parser.forall_vars = snapshot['forall_vars']
+  parser.exists_vars = snapshot['exists_vars']
+  parser.dependencies = snapshot['dependencies']
+  parser.gates = snapshot['gates']
+  parser.gate_aliases = snapshot['gate_aliases']
+  parser.output_gate = snapshot['output_gate']
+  parser.forall_vars_ordered = snapshot['forall_vars_ordered']
+  parser.cnf = snapshot['cnf']
+  parser.aux_vars = snapshot['aux_vars']
+  parser.merged_gate_count = snapshot['merged_gate_count']
+  parser.reduction_stats = snapshot['reduction_stats']
+
+  logging.debug(f"Loaded formula cache from {path}")
+  return parser
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Instrumentation Facade
+
+Lightweight tracing and counting for the hot CEGAR loop. Debug logging in the
+solver previously evaluated its arguments unconditionally (formatting and
+sorting every clause even with -v off); this facade exposes a cached
+trace_enabled flag so hot paths can skip argument evaluation entirely, a
+lazily-evaluated trace point for colder paths, and simple integer counters
+(SAT calls, clauses added, rules learned) surfaced through get_statistics.
+"""
+
+import logging
+from typing import Callable, Dict
+
+
+class Instrumentation:
+  """Guarded, lazily-evaluated trace points plus performance counters."""
+
+  def __init__(self):
+    # Cached once; hot paths test this flag instead of calling into logging
+    self.trace_enabled = logging.getLogger().isEnabledFor(logging.DEBUG)
+
+    # Named integer counters
+    self.counters: Dict[str, int] = {}
+
+  def refresh(self) -> None:
+    """Re-evaluate the trace flag (call after reconfiguring logging)."""
+    self.trace_enabled = logging.getLogger().isEnabledFor(logging.DEBUG)
+
+  def trace(self, message_fn: Callable[[], str]) -> None:
+    """Emit a debug trace line; message_fn is only evaluated when tracing is on.
+
+    Args:
+      message_fn: Zero-argument callable producing the message string
+    """
+    if self.trace_enabled:
+      logging.debug(message_fn())
+
+  def count(self, name: str, amount: int = 1) -> None:
+    """Increment a named counter."""
+    self.counters[name] = self.counters.get(name, 0) + amount
+
+  def get_counters(self) -> Dict[str, int]:
+    """Return a snapshot of all counters."""
+    return dict(self.counters)
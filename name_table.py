@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Lazy Variable Name Table
+
+Display names for solver-created auxiliary variables used to be eagerly
+built f-strings stored in id_to_name; an expansion variable over thousands
+of dependency literals carries a multi-kilobyte name, and on long runs the
+name dictionary dominated resident memory. This table instead stores one
+compact structured record per auxiliary variable (kind, parent variable ID,
+rule index or assignment tuple, shared with the solver's own bookkeeping)
+and synthesizes the display string only when a name is actually requested
+for tracing or verbose output.
+"""
+
+from typing import Dict, Optional, Tuple
+
+# Record kinds for solver-created auxiliary variables
+KIND_VALUE = 'value'
+KIND_NOFIRED = 'nofired'
+KIND_FIRE = 'fire'
+KIND_EXPANSION = 'expansion'
+
+
+class NameTable:
+  """Lazily synthesized display names backed by compact records."""
+
+  def __init__(self, base_names: Dict[int, str]):
+    """Initialize the name table.
+
+    Args:
+      base_names: Dictionary mapping variable IDs to parser-assigned names
+                  (variables and gates from the input file). The table keeps
+                  a live reference and consults it before its own records.
+    """
+    self.base_names = base_names
+
+    # Compact records for auxiliary variables:
+    #   (KIND_VALUE, parent_id, rule_index)
+    #   (KIND_NOFIRED, parent_id, rule_index)
+    #   (KIND_FIRE, parent_id, rule_index, premise tuple or None)
+    #   (KIND_EXPANSION, parent_id, assignment tuple)
+    # Premise and assignment tuples are shared with the solver's rule and
+    # expansion bookkeeping, so no literal list is stored twice
+    self.records: Dict[int, Tuple] = {}
+
+  def register_value(self, var_id: int, parent_id: int, rule_index: int) -> None:
+    """Register a value variable for rule rule_index of parent_id."""
+    self.records[var_id] = (KIND_VALUE, parent_id, rule_index)
+
+  def register_no_rule_fired(self, var_id: int, parent_id: int, rule_index: int) -> None:
+    """Register a no_rule_fired variable gating rule rule_index + 1."""
+    self.records[var_id] = (KIND_NOFIRED, parent_id, rule_index)
+
+  def register_fire(self, var_id: int, parent_id: int, rule_index: int) -> None:
+    """Register a rule fire variable (premise still open)."""
+    self.records[var_id] = (KIND_FIRE, parent_id, rule_index, None)
+
+  def set_fire_premise(self, var_id: int, premise: Tuple[int, ...]) -> None:
+    """Attach a premise to a previously registered fire variable.
+
+    Args:
+      var_id: The fire variable's ID
+      premise: The premise literal tuple (shared with the rule registry)
+    """
+    record = self.records.get(var_id)
+    if record is not None and record[0] == KIND_FIRE:
+      self.records[var_id] = (KIND_FIRE, record[1], record[2], premise)
+
+  def register_expansion(self, var_id: int, parent_id: int, assignment: Tuple[int, ...]) -> None:
+    """Register an expansion variable for parent_id under an assignment.
+
+    Args:
+      var_id: The expansion variable's ID
+      parent_id: The existential variable the expansion value belongs to
+      assignment: Canonical assignment tuple (shared with the solver)
+    """
+    self.records[var_id] = (KIND_EXPANSION, parent_id, assignment)
+
+  def drop_rule_records(self) -> None:
+    """Drop records for decision-list variables, keeping expansion variables.
+
+    Called when decision lists are compacted and rebuilt: the replaced
+    value/fire/no_rule_fired variables are dead, while expansion variables
+    survive the rebuild and keep their names.
+    """
+    self.records = {var_id: record for var_id, record in self.records.items()
+                    if record[0] == KIND_EXPANSION}
+
+  def name_of(self, var_id: int) -> str:
+    """Return the display name for a variable, synthesizing it if needed.
+
+    Args:
+      var_id: The variable ID to name
+
+    Returns:
+      The parser-assigned name, a synthesized auxiliary name, or a generic
+      "id<N>" label for unknown variables
+    """
+    name = self.base_names.get(var_id)
+    if name is not None:
+      return name
+
+    record = self.records.get(var_id)
+    if record is None:
+      return f"id{var_id}"
+
+    kind = record[0]
+    parent_name = self.base_names.get(record[1], f"var{record[1]}")
+
+    if kind == KIND_VALUE:
+      return f"{parent_name}_value_{record[2]}"
+    if kind == KIND_NOFIRED:
+      return f"{parent_name}_nofired_{record[2]}"
+    if kind == KIND_FIRE:
+      premise = record[3]
+      if premise is None:
+        return f"{parent_name}_fire_{record[2]}"
+      premise_name = self._format_premise(premise) if premise else "true"
+      return f"{parent_name}_fire_{record[2]}_premise_{premise_name}"
+    if kind == KIND_EXPANSION:
+      assignment_str = "_".join(f"{abs(lit)}={'T' if lit > 0 else 'F'}"
+                                for lit in record[2])
+      return f"exp_{parent_name}_{assignment_str}"
+
+    return f"id{var_id}"
+
+  def _format_premise(self, premise: Tuple[int, ...]) -> str:
+    """Format a premise tuple like "[x1, ~x2, ...]" using base names."""
+    parts = []
+    for lit in sorted(premise, key=abs):
+      lit_name = self.base_names.get(abs(lit), f"id{abs(lit)}")
+      parts.append(lit_name if lit > 0 else f"~{lit_name}")
+    return "[" + ", ".join(parts) + "]"
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Counterexample Polarity Statistics
+
+Flipping an existential's default value to oppose the last counterexample
+makes oscillating instances thrash: each flip invalidates the usefulness
+of rules learned under the previous default and the decision lists grow
+with redundant point rules. This tracker keeps a sliding window of the
+default values recent counterexamples asked for, per existential, and
+recommends the window majority — but only actually flips when the
+majority margin reaches a hysteresis threshold, so a single outlier
+counterexample cannot toggle the default back and forth.
+"""
+
+from collections import deque
+from typing import Deque, Dict
+
+
+class PolarityTracker:
+  """Sliding-window polarity counts with hysteresis, per existential."""
+
+  def __init__(self, window: int, hysteresis: int):
+    """Initialize the tracker.
+
+    Args:
+      window: Number of recent counterexamples kept per existential
+      hysteresis: Minimum majority margin (trues minus falses, or vice
+                  versa) required before a default flip is recommended
+    """
+    self.window = window
+    self.hysteresis = hysteresis
+    self._history: Dict[int, Deque[bool]] = {}
+    self._true_counts: Dict[int, int] = {}
+
+  def record(self, exist_id: int, wanted_default: bool) -> None:
+    """Record the default value one counterexample asked for.
+
+    Args:
+      exist_id: The existential variable the counterexample failed on
+      wanted_default: The default that would have avoided the failure
+                      (the opposite of the failing polarity)
+    """
+    history = self._history.get(exist_id)
+    if history is None:
+      history = deque()
+      self._history[exist_id] = history
+      self._true_counts[exist_id] = 0
+
+    history.append(wanted_default)
+    if wanted_default:
+      self._true_counts[exist_id] += 1
+    if len(history) > self.window:
+      if history.popleft():
+        self._true_counts[exist_id] -= 1
+
+  def preferred_default(self, exist_id: int, current_default: bool) -> bool:
+    """Return the default to use, flipping only past the hysteresis margin.
+
+    Args:
+      exist_id: The existential variable being decided
+      current_default: The variable's default before this counterexample
+
+    Returns:
+      The window majority if it disagrees with the current default by at
+      least the hysteresis margin, otherwise the current default
+    """
+    history = self._history.get(exist_id)
+    if not history:
+      return current_default
+
+    trues = self._true_counts[exist_id]
+    margin = trues - (len(history) - trues)
+    if current_default and margin <= -self.hysteresis:
+      return False
+    if not current_default and margin >= self.hysteresis:
+      return True
+    return current_default
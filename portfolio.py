@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Portfolio Counterexample Search
+
+Runs the step-1 counterexample query of the CEGAR loop on several SAT
+backends in parallel worker processes and takes the first answer. Variance
+between SAT heuristics on hard queries is huge, so a small portfolio often
+answers in a fraction of the time of any fixed backend, and the CEGAR loop
+itself is strictly sequential — this is where the remaining cores go.
+
+Each worker owns a private solver bootstrapped with the matrix and receives
+every clause the main solver learns (rule definitions, selector-guarded
+blocking clauses) over a pipe, so all portfolio members stay logically
+equivalent to the main counterexample solver. When one worker answers, the
+others are still stuck inside their backend's solve call and cannot be
+interrupted portably; they are terminated and respawned from the matrix
+plus the accumulated clause log instead.
+"""
+
+import logging
+import multiprocessing
+from multiprocessing.connection import wait
+from typing import List, Optional, Tuple
+
+# Backends cycled through when building a portfolio; different heuristics
+# matter more than instance count, so repeats only occur past this list
+DEFAULT_BACKENDS = ['cadical195', 'glucose42', 'minisat22', 'lingeling']
+
+
+def _worker_main(backend: str, matrix: List[List[int]], clause_log: List[List[int]], conn) -> None:
+  """Worker process loop: own one solver, answer solve requests over a pipe.
+
+  Args:
+    backend: PySAT backend name for this worker's solver
+    matrix: CNF matrix to bootstrap the solver with
+    clause_log: Clauses learned before this worker was (re)spawned
+    conn: Pipe endpoint for commands and results
+  """
+  from pysat.solvers import Solver
+
+  solver = Solver(name=backend, bootstrap_with=matrix)
+  for clause in clause_log:
+    solver.add_clause(clause)
+
+  while True:
+    command = conn.recv()
+    op = command[0]
+    if op == 'add_clause':
+      solver.add_clause(command[1])
+    elif op == 'solve':
+      query_id, assumptions = command[1], command[2]
+      result = solver.solve(assumptions=assumptions)
+      model = solver.get_model() if result else None
+      conn.send((query_id, result, model))
+    elif op == 'stop':
+      conn.close()
+      return
+
+
+class PortfolioSolver:
+  """Portfolio of SAT worker processes answering the same queries."""
+
+  def __init__(self, matrix: List[List[int]], size: int, backends: Optional[List[str]] = None):
+    """Initialize the portfolio and spawn its workers.
+
+    Args:
+      matrix: CNF matrix all workers are bootstrapped with
+      size: Number of worker processes (at least 1)
+      backends: Optional backend names; defaults to cycling DEFAULT_BACKENDS
+    """
+    self.matrix = matrix
+    if backends is None:
+      backends = [DEFAULT_BACKENDS[i % len(DEFAULT_BACKENDS)] for i in range(max(1, size))]
+    self.backends = backends
+
+    # Every learned clause, replayed into respawned workers
+    self.clause_log: List[List[int]] = []
+
+    self.query_id = 0
+
+    # One (process, pipe endpoint) pair per backend
+    self.workers: List[Tuple[multiprocessing.Process, object]] = []
+    for backend in self.backends:
+      self.workers.append(self._spawn(backend))
+
+    logging.debug(f"Portfolio started with backends: {', '.join(self.backends)}")
+
+  def _spawn(self, backend: str) -> Tuple[multiprocessing.Process, object]:
+    """Spawn one worker process for a backend, replaying the clause log."""
+    parent_conn, child_conn = multiprocessing.Pipe()
+    process = multiprocessing.Process(
+      target=_worker_main,
+      args=(backend, self.matrix, list(self.clause_log), child_conn),
+      daemon=True
+    )
+    process.start()
+    child_conn.close()
+    return (process, parent_conn)
+
+  def add_clause(self, clause: List[int]) -> None:
+    """Forward a learned clause to every worker (and the replay log)."""
+    self.clause_log.append(clause)
+    for index, (process, conn) in enumerate(self.workers):
+      try:
+        conn.send(('add_clause', clause))
+      except (BrokenPipeError, OSError):
+        # Worker died unexpectedly; bring it back in sync
+        self.workers[index] = self._spawn(self.backends[index])
+
+  def solve(self, assumptions: List[int]) -> Tuple[bool, Optional[List[int]]]:
+    """Run one query on all workers and return the first answer.
+
+    Workers that have not answered by then are terminated and respawned so
+    the next query starts from a clean, in-sync solver.
+
+    Args:
+      assumptions: Assumption literals for the query
+
+    Returns:
+      (result, model) where model is the winning worker's full model for a
+      SAT answer and None for UNSAT
+    """
+    self.query_id += 1
+    for index, (process, conn) in enumerate(self.workers):
+      try:
+        conn.send(('solve', self.query_id, list(assumptions)))
+      except (BrokenPipeError, OSError):
+        self.workers[index] = self._spawn(self.backends[index])
+        self.workers[index][1].send(('solve', self.query_id, list(assumptions)))
+
+    connections = [conn for _, conn in self.workers]
+    while True:
+      for conn in wait(connections):
+        try:
+          query_id, result, model = conn.recv()
+        except (EOFError, OSError):
+          # Worker died mid-query; respawn it and re-send the query so the
+          # portfolio never runs dry (wait([]) would block forever)
+          index = next(i for i, (_, c) in enumerate(self.workers) if c is conn)
+          connections.remove(conn)
+          self.workers[index] = self._spawn(self.backends[index])
+          self.workers[index][1].send(('solve', self.query_id, list(assumptions)))
+          connections.append(self.workers[index][1])
+          continue
+        if query_id != self.query_id:
+          # Stale answer from a query this worker missed the cancel for
+          continue
+
+        winner = next(i for i, (_, c) in enumerate(self.workers) if c is conn)
+        logging.debug(f"Portfolio query {self.query_id} answered by {self.backends[winner]}")
+        self._cancel_losers(winner)
+        return (result, model)
+
+  def _cancel_losers(self, winner: int) -> None:
+    """Terminate and respawn every worker still computing the last query."""
+    for index, (process, conn) in enumerate(self.workers):
+      if index == winner:
+        continue
+      # A worker that already answered (stale or tied) can be kept as-is
+      if conn.poll():
+        try:
+          conn.recv()
+          continue
+        except (EOFError, OSError):
+          pass
+      process.terminate()
+      process.join()
+      conn.close()
+      self.workers[index] = self._spawn(self.backends[index])
+
+  def reset(self) -> None:
+    """Discard the clause log and restart all workers from the bare matrix.
+
+    Used when the main solver is rebuilt (decision-list compaction): the
+    caller re-sends the surviving clauses through add_clause afterwards.
+    """
+    self.clause_log = []
+    for index, (process, conn) in enumerate(self.workers):
+      try:
+        conn.send(('stop',))
+      except (BrokenPipeError, OSError):
+        pass
+      process.join(timeout=1)
+      if process.is_alive():
+        process.terminate()
+        process.join()
+      conn.close()
+      self.workers[index] = self._spawn(self.backends[index])
+
+  def stop(self) -> None:
+    """Shut down all worker processes."""
+    for process, conn in self.workers:
+      try:
+        conn.send(('stop',))
+      except (BrokenPipeError, OSError):
+        pass
+      process.join(timeout=1)
+      if process.is_alive():
+        process.terminate()
+        process.join()
+      conn.close()
+    self.workers = []
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Per-Phase Profiling
+
+Monotonic-clock accumulators around the solver's phases (parsing, CNF
+translation, the step-1 and step-2 solves of counterexample extraction,
+premise minimization, rule clause generation, expansion solving), plus a
+log-scale histogram of individual SAT-call durations. Enabled through the
+--profile CLI flag; a breakdown table is printed at exit and on SIGUSR1,
+so long runs can be inspected live without attaching a debugger or
+forking the code to add timers by hand.
+
+When disabled (the default), phase() hands out a shared no-op context
+manager so the hot path pays one attribute check per phase and nothing
+else.
+"""
+
+import logging
+import signal
+import time
+from contextlib import contextmanager
+from typing import Dict, Optional
+
+# SAT-call duration histogram bucket upper bounds (seconds) and labels
+SAT_BUCKETS = [0.001, 0.01, 0.1, 1.0, 10.0, float('inf')]
+SAT_BUCKET_LABELS = ['<1ms', '<10ms', '<100ms', '<1s', '<10s', '>=10s']
+
+
+class _NullContext:
+  """Shared do-nothing context manager for disabled profilers."""
+
+  def __enter__(self):
+    return self
+
+  def __exit__(self, exc_type, exc_value, traceback):
+    return False
+
+
+_NULL_CONTEXT = _NullContext()
+
+
+class PhaseProfiler:
+  """Accumulates wall time per named phase and a SAT-call duration histogram."""
+
+  def __init__(self, enabled: bool = True):
+    """Initialize the profiler.
+
+    Args:
+      enabled: When False, phase() is a no-op and nothing is recorded
+    """
+    self.enabled = enabled
+    self.phase_seconds: Dict[str, float] = {}
+    self.phase_calls: Dict[str, int] = {}
+    self.sat_histogram = [0] * len(SAT_BUCKETS)
+    self.start_time = time.monotonic()
+
+  def phase(self, name: str, sat_call: bool = False):
+    """Return a context manager timing one phase entry.
+
+    Args:
+      name: Phase name the elapsed time is accumulated under
+      sat_call: When True, the duration is also added to the SAT-call
+                histogram (use for individual solver solve() calls)
+    """
+    if not self.enabled:
+      return _NULL_CONTEXT
+    return self._timed(name, sat_call)
+
+  @contextmanager
+  def _timed(self, name: str, sat_call: bool):
+    start = time.monotonic()
+    try:
+      yield
+    finally:
+      elapsed = time.monotonic() - start
+      self.phase_seconds[name] = self.phase_seconds.get(name, 0.0) + elapsed
+      self.phase_calls[name] = self.phase_calls.get(name, 0) + 1
+      if sat_call:
+        for index, bound in enumerate(SAT_BUCKETS):
+          if elapsed < bound:
+            self.sat_histogram[index] += 1
+            break
+
+  def report(self, counters: Optional[Dict[str, int]] = None) -> str:
+    """Render the profile as a breakdown table.
+
+    Args:
+      counters: Optional counter dictionary (e.g. Instrumentation
+                counters) appended below the timing table
+
+    Returns:
+      Multi-line report string
+    """
+    lines = []
+    total = time.monotonic() - self.start_time
+    lines.append(f"Profile after {total:.2f}s wall time:")
+    lines.append(f"  {'phase':<24} {'calls':>10} {'total':>10} {'avg':>10} {'share':>7}")
+
+    for name in sorted(self.phase_seconds, key=self.phase_seconds.get, reverse=True):
+      seconds = self.phase_seconds[name]
+      calls = self.phase_calls[name]
+      avg_ms = seconds / calls * 1000.0
+      share = seconds / total * 100.0 if total > 0 else 0.0
+      lines.append(f"  {name:<24} {calls:>10} {seconds:>9.3f}s {avg_ms:>8.2f}ms {share:>6.1f}%")
+
+    if any(self.sat_histogram):
+      lines.append("  SAT-call durations:")
+      for label, count in zip(SAT_BUCKET_LABELS, self.sat_histogram):
+        if count:
+          lines.append(f"    {label:<8} {count}")
+
+    if counters:
+      lines.append("  Counters:")
+      for name in sorted(counters):
+        lines.append(f"    {name}: {counters[name]}")
+
+    return "\n".join(lines)
+
+  def install_signal_handler(self, counters_fn=None) -> None:
+    """Print the current breakdown on SIGUSR1, for inspecting live runs.
+
+    Args:
+      counters_fn: Optional callable returning a counter dictionary to
+                   include in the report (evaluated at signal time)
+    """
+    def handler(signum, frame):
+      counters = counters_fn() if counters_fn is not None else None
+      logging.info("\n" + self.report(counters))
+
+    signal.signal(signal.SIGUSR1, handler)
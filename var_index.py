@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Variable-Kind Index
+
+A dense byte-array index that classifies variable IDs by kind (universal,
+existential, expansion, or auxiliary). It replaces repeated linear membership
+scans over Python lists when partitioning large SAT models.
+
+IDs handed out by Counter.increase that are never explicitly marked are
+classified as auxiliary, so only the interesting kinds need registration.
+"""
+
+from typing import Iterable, List, Tuple
+
+# Variable kinds. AUX is the default for unregistered IDs.
+KIND_AUX = 0
+KIND_UNIVERSAL = 1
+KIND_EXISTENTIAL = 2
+KIND_EXPANSION = 3
+
+
+class VariableKindIndex:
+  """Dense array mapping variable IDs to their kind.
+
+  The index grows on demand as new variable IDs are marked; lookups beyond
+  the current size report KIND_AUX without growing the array.
+  """
+
+  def __init__(self, size_hint: int = 0):
+    """Initialize the index.
+
+    Args:
+      size_hint: Expected maximum variable ID (e.g. the current Counter value).
+            The index still grows automatically if exceeded.
+    """
+    self._kinds = bytearray(size_hint + 1)
+
+  def _ensure_size(self, var_id: int) -> None:
+    """Grow the backing array so that var_id is a valid index."""
+    if var_id >= len(self._kinds):
+      # Grow geometrically to amortize repeated single-ID marks
+      new_size = max(var_id + 1, 2 * len(self._kinds))
+      self._kinds.extend(bytearray(new_size - len(self._kinds)))
+
+  def mark(self, var_id: int, kind: int) -> None:
+    """Mark a single variable ID with the given kind."""
+    self._ensure_size(var_id)
+    self._kinds[var_id] = kind
+
+  def mark_all(self, var_ids: Iterable[int], kind: int) -> None:
+    """Mark a collection of variable IDs with the given kind."""
+    for var_id in var_ids:
+      self.mark(var_id, kind)
+
+  def kind_of(self, var_id: int) -> int:
+    """Return the kind of a variable ID (KIND_AUX if never marked)."""
+    if var_id < len(self._kinds):
+      return self._kinds[var_id]
+    return KIND_AUX
+
+  def is_universal(self, var_id: int) -> bool:
+    """Check whether a variable ID is marked universal."""
+    return self.kind_of(var_id) == KIND_UNIVERSAL
+
+  def is_existential(self, var_id: int) -> bool:
+    """Check whether a variable ID is marked existential."""
+    return self.kind_of(var_id) == KIND_EXISTENTIAL
+
+  def is_expansion(self, var_id: int) -> bool:
+    """Check whether a variable ID is marked as an expansion variable."""
+    return self.kind_of(var_id) == KIND_EXPANSION
+
+  def partition_model(self, model: Iterable[int]) -> Tuple[List[int], List[int], List[int]]:
+    """Partition a SAT model into universal, existential, and other literals.
+
+    Args:
+      model: Iterable of literals (as returned by a SAT solver's get_model)
+
+    Returns:
+      Tuple (universals, existentials, aux) where each element is the list of
+      model literals whose variable has the corresponding kind. Expansion
+      variables are reported in the aux bucket.
+    """
+    kinds = self._kinds
+    size = len(kinds)
+    universals: List[int] = []
+    existentials: List[int] = []
+    aux: List[int] = []
+    for lit in model:
+      var_id = abs(lit)
+      kind = kinds[var_id] if var_id < size else KIND_AUX
+      if kind == KIND_UNIVERSAL:
+        universals.append(lit)
+      elif kind == KIND_EXISTENTIAL:
+        existentials.append(lit)
+      else:
+        aux.append(lit)
+    return (universals, existentials, aux)
+
+  def filter_kind(self, literals: Iterable[int], kind: int) -> List[int]:
+    """Return the literals whose variable has the given kind."""
+    kinds = self._kinds
+    size = len(kinds)
+    return [lit for lit in literals
+            if (kinds[abs(lit)] if abs(lit) < size else KIND_AUX) == kind]